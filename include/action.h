@@ -106,6 +106,8 @@
     X(ACTION_RESIZE_TO, false, "RESIZE-TO", DATA_TYPE_QUAD) \
     /* center a window to given monitor (glob pattern) or the monitor the window is currently on */ \
     X(ACTION_CENTER_TO, true, "CENTER-TO", DATA_TYPE_STRING) \
+    /* write the latency histograms to the requester or standard error output */ \
+    X(ACTION_DUMP_LATENCIES, false, "DUMP-LATENCIES", DATA_TYPE_VOID) \
     /* quit fensterchef */ \
     X(ACTION_QUIT, false, "QUIT", DATA_TYPE_VOID)
 
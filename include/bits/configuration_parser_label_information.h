@@ -75,6 +75,8 @@ static const struct configuration_parser_label_name {
             offsetof(struct configuration, font.use_core_font) },
         { "name", DATA_TYPE_STRING,
             offsetof(struct configuration, font.name) },
+        { "cache-glyphs", DATA_TYPE_BOOLEAN,
+            offsetof(struct configuration, font.cache_glyphs) },
         /* null terminate the end */
         { NULL, 0, 0 } }
     },
@@ -125,6 +125,10 @@ struct configuration_font {
     bool use_core_font;
     /* name of the font in fontconfig format */
     utf8_t *name;
+    /* whether to keep rendered glyphs in a file so they do not need to be
+     * rendered again on the next start
+     */
+    bool cache_glyphs;
 };
 
 /* border settings */
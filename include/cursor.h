@@ -123,6 +123,33 @@ extern const char *xcursor_core_strings[XCURSOR_MAX];
 /* Translate a string to a cursor constant. */
 core_cursor_t string_to_cursor(const char *string);
 
+/* expands to all filters that can be used to resize cursor images */
+#define DEFINE_ALL_XCURSOR_FILTERS \
+    /* average the covered pixels when shrinking and interpolate linearly when
+     * growing */ \
+    X(XCURSOR_FILTER_SMOOTH, "smooth") \
+    /* copy the closest pixel */ \
+    X(XCURSOR_FILTER_NEAREST, "nearest") \
+    /* interpolate linearly between the four closest pixels */ \
+    X(XCURSOR_FILTER_BILINEAR, "bilinear") \
+    /* average all pixels covered by a pixel */ \
+    X(XCURSOR_FILTER_BOX, "box")
+
+typedef enum {
+#define X(constant, string) constant,
+    DEFINE_ALL_XCURSOR_FILTERS
+
+    /* indicator for the the number of filters */
+    XCURSOR_FILTER_MAX
+#undef X
+} xcursor_filter_t;
+
+/* Translate a string to a filter constant.
+ *
+ * @return XCURSOR_FILTER_MAX if the string is not a valid filter.
+ */
+xcursor_filter_t string_to_xcursor_filter(const char *string);
+
 /* data to manage cursors */
 extern struct xcursor {
     /* if animated cursors are enabled */
@@ -133,6 +160,8 @@ extern struct xcursor {
     char *path;
     /* if the cursor should be resized */
     bool resized;
+    /* the filter used for resizing */
+    xcursor_filter_t filter;
     /* preferred size of the cursor */
     uint32_t size;
     /* name of the cursor theme */
@@ -153,6 +182,12 @@ extern struct xcursor {
  */
 bool xcursor_string_to_boolean(const char *string);
 
+/* Set the filter used for resizing cursors from its name.
+ *
+ * Invalid names are ignored.
+ */
+void set_xcursor_filter(const char *name);
+
 /* Set the Xcursor data settings to the default. */
 void set_default_xcursor_settings(void);
 
@@ -301,15 +336,19 @@ typedef enum xcursor_error {
 /* translation of error to string */
 extern const char *xcursor_error_strings[XCURSOR_ERROR_MAX];
 
-/* Read a file as cursor file.
+/* Read the file at @path as cursor file.
+ *
+ * The file is mapped into memory and only the images with the size closest to
+ * @size are decoded.
  *
  * The data in @xcursor is invalid when this function fails.
  *
  * @return XCURSOR_SUCCESS if the file format was correct.
  */
-xcursor_error_t load_cursor_file(FILE *file, struct xcursor_file *xcursor);
+xcursor_error_t load_cursor_file(const char *path, uint32_t size,
+        struct xcursor_file *xcursor);
 
-/* Clear the resources occupied by @file. */
+/* Clear the resources occupied by @xcursor. */
 void clear_cursor_file(struct xcursor_file *xcursor);
 
 /* Load the cursor with given name using the user's preferred style. */
@@ -16,10 +16,14 @@ extern bool is_reload_requested;
  */
 extern bool has_client_list_changed;
 
-/* Create a signal handler for `SIGALRM`. */
+/* Create a signal handler for `SIGALRM` and `SIGUSR1`. */
 int initialize_signal_handlers(void);
 
-/* Set the client list root property. */
+/* Set the client list root properties.
+ *
+ * Only the difference to the last call is sent: new ids are appended and the
+ * property is only replaced when windows were removed or restacked.
+ */
 void synchronize_client_list(void);
 
 /* Synchronize the local data with the X server. */
@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <stdio.h>
 
+#include <xcb/xcb.h>
+
 #include "utf8.h"
 
 #define FENSTERCHEF_NAME "fensterchef"
@@ -21,7 +23,10 @@ extern char *Fensterchef_configuration;
 /* true while the window manager is running */
 extern bool Fensterchef_is_running;
 
-/* Spawn a window that has the `FENSTERCHEF_COMMAND` property.
+/* Send @command to the running fensterchef instance.
+ *
+ * This first tries the socket (see "ipc.h") and falls back to spawning a window
+ * that has the `FENSTERCHEF_COMMAND` property.
  *
  * This should be called before any initialization has be done.
  *
@@ -30,6 +35,12 @@ extern bool Fensterchef_is_running;
  */
 void run_external_command(const char *command);
 
+/* Parse @command as list of actions and run them.
+ *
+ * @return the result of the last action or false if @command is invalid.
+ */
+bool run_command(const char *command);
+
 /* Close the connection to xcb and exit the program with given exit code. */
 void quit_fensterchef(int exit_code);
 
@@ -42,4 +53,7 @@ void quit_fensterchef(int exit_code);
  */
 void set_notification(const utf8_t *message, int32_t x, int32_t y);
 
+/* Copy the exposed region of the notification window from its back buffer. */
+void handle_notification_expose(xcb_expose_event_t *event);
+
 #endif
@@ -138,6 +138,15 @@ Frame *get_frame_at_position(int32_t x, int32_t y);
  */
 void replace_frame(Frame *frame, Frame *with);
 
+/* Set the window inside @frame to @window.
+ *
+ * Always use this instead of assigning `frame->window` directly so that the
+ * frame pointer within the window stays consistent.
+ *
+ * @window may be NULL to make the frame empty.
+ */
+void set_frame_window(Frame *frame, Window *window);
+
 /* Get the gaps the frame applies to its inner window. */
 void get_frame_gaps(const Frame *frame, Extents *gaps);
 
@@ -0,0 +1,118 @@
+#ifndef IPC_H
+#define IPC_H
+
+/**
+ * External programs can run commands through a Unix domain socket.
+ *
+ * The socket is at "$XDG_RUNTIME_DIR/fensterchef-$DISPLAY" or at
+ * "/tmp/fensterchef-$UID-$DISPLAY" if `XDG_RUNTIME_DIR` is not set.
+ * Only the user running fensterchef may connect to it, clients of other users
+ * are rejected.
+ *
+ * A client sends commands separated by new lines, each command is a list of
+ * actions just like a command given through `fensterchef --command`.
+ * For each command, a line with either "true" or "false" is sent back which is
+ * the result of the last action. Actions producing output (`dump-latencies`)
+ * send it before that line. Many commands can be sent over the same
+ * connection. When the client closes its writing side, the connection is
+ * closed after all replies are sent.
+ *
+ * A client may also send "subscribe EVENT..." (or just "subscribe" for all
+ * events) to receive a line for every event of that kind. Each line starts
+ * with the name of the event followed by its data. When a client does not read
+ * fast enough, records are dropped and a "dropped COUNT" line is sent once
+ * there is space again.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/select.h>
+
+/* expands to all events clients can subscribe to */
+#define DEFINE_ALL_IPC_EVENTS \
+    /* focus WINDOW_ID - the focused window changed (0 if no window) */ \
+    X(IPC_EVENT_FOCUS, "focus") \
+    /* frame-focus NUMBER X Y WIDTH HEIGHT - the focused frame changed */ \
+    X(IPC_EVENT_FRAME_FOCUS, "frame-focus") \
+    /* window-created WINDOW_ID NUMBER - a window is now managed */ \
+    X(IPC_EVENT_WINDOW_CREATED, "window-created") \
+    /* window-destroyed WINDOW_ID NUMBER - a window is no longer managed */ \
+    X(IPC_EVENT_WINDOW_DESTROYED, "window-destroyed") \
+    /* mode WINDOW_ID MODE - the mode of a window changed */ \
+    X(IPC_EVENT_MODE, "mode") \
+    /* frame-split X Y WIDTH HEIGHT - a frame was split */ \
+    X(IPC_EVENT_FRAME_SPLIT, "frame-split") \
+    /* frame-removed X Y WIDTH HEIGHT - a frame was removed */ \
+    X(IPC_EVENT_FRAME_REMOVED, "frame-removed") \
+    /* monitors COUNT - the monitor configuration changed */ \
+    X(IPC_EVENT_MONITORS, "monitors")
+
+/* constant list expansion of all events */
+typedef enum ipc_event {
+#define X(event, name) event,
+    DEFINE_ALL_IPC_EVENTS
+#undef X
+    IPC_EVENT_MAX
+} ipc_event_t;
+
+/* the maximum number of clients connected at once */
+#define IPC_MAXIMUM_CONNECTIONS 32
+
+/* the maximum length of a single command including the new line */
+#define IPC_MAXIMUM_COMMAND_LENGTH 4096
+
+/* the maximum number of bytes that can be queued up for a client, when a
+ * client does not read its replies and exceeds this, it is disconnected; event
+ * lines exceeding this are dropped instead
+ */
+#define IPC_MAXIMUM_OUTPUT_LENGTH 65536
+
+/* Create the socket external programs can connect to.
+ *
+ * @return ERROR if the socket could not be created.
+ */
+int initialize_ipc(void);
+
+/* Close all connections and remove the socket. */
+void deinitialize_ipc(void);
+
+/* Add the file descriptors of the socket and all connections to @read_set and
+ * @write_set.
+ *
+ * @return the highest file descriptor added or -1 if none was added.
+ */
+int set_ipc_file_descriptors(fd_set *read_set, fd_set *write_set);
+
+/* Accept new connections, run received commands and send queued replies for
+ * all file descriptors that are ready.
+ */
+void handle_ipc_file_descriptors(const fd_set *read_set,
+        const fd_set *write_set);
+
+/* Get the stream the output of the running command goes to.
+ *
+ * For commands sent by a client, the output is sent to it before the result
+ * line, otherwise this is standard error output.
+ */
+FILE *get_command_output(void);
+
+/* Queue a line for all clients subscribed to @event.
+ *
+ * The line consists of the event name followed by a space and @format
+ * formatted like `printf()`.
+ *
+ * The lines are sent at the end of the current cycle by `flush_ipc_events()`.
+ */
+void publish_ipc_event(ipc_event_t event, const char *format, ...);
+
+/* Send as much of the queued lines to all clients as possible. */
+void flush_ipc_events(void);
+
+/* Connect to the socket of a running fensterchef instance, send @command and
+ * wait for the reply.
+ *
+ * @return ERROR if no connection could be made.
+ */
+int send_ipc_command(const char *command);
+
+#endif
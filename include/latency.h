@@ -0,0 +1,106 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+/**
+ * Histograms of how long the handling of each event type and the
+ * synchronization steps of each cycle take.
+ *
+ * Every measured duration goes into a bucket by its power of two in
+ * nanoseconds. The histograms are written to standard error output by sending
+ * `SIGUSR1` to fensterchef or through the `dump-latencies` action which sends
+ * them back to the client when run through the socket. The dump does not
+ * depend on the log severity.
+ *
+ * All waits for a reply from the X server go through `ROUND_TRIP()` which
+ * accounts the time blocked to the calling file and line and to the action
+ * that is currently running. The call sites and actions that blocked the
+ * longest are part of the same dump.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "action.h"
+
+/* expands to all measured operations that are not events */
+#define DEFINE_ALL_LATENCY_OPERATIONS \
+    /* applying the dirty windows to the server */ \
+    X(LATENCY_SYNCHRONIZE_WITH_SERVER, "synchronize-with-server") \
+    /* updating the client list root properties */ \
+    X(LATENCY_SYNCHRONIZE_CLIENT_LIST, "synchronize-client-list") \
+    /* changing the input focus */ \
+    X(LATENCY_SET_INPUT_FOCUS, "set-input-focus") \
+    /* flushing the requests at the end of a cycle */ \
+    X(LATENCY_FLUSH, "flush")
+
+/* the number of event types, events use their type as latency index */
+#define LATENCY_EVENT_TYPES 128
+
+/* the number of buckets in each histogram, the last bucket also holds all
+ * longer durations
+ */
+#define LATENCY_BUCKETS 32
+
+/* the maximum number of call sites round trips are accounted to, this must be
+ * a power of two
+ */
+#define ROUND_TRIP_MAXIMUM_SITES 256
+
+/* the number of call sites shown in the dump */
+#define ROUND_TRIP_REPORTED_SITES 16
+
+/* Wait for the reply of @call which is a `xcb_*_reply()` or
+ * `xcb_request_check()` call returning a pointer and account the blocked time.
+ */
+#define ROUND_TRIP(call) ROUND_TRIP_AT(__FILE__, __LINE__, call)
+
+/* Like `ROUND_TRIP()` but account to @file and @line, this is for helpers
+ * that pass on the location of their caller.
+ */
+#define ROUND_TRIP_AT(file, line, call) \
+    (begin_round_trip(), end_round_trip((file), (line), (call)))
+
+/* Like `ROUND_TRIP()` but for reply functions returning a status. */
+#define ROUND_TRIP_STATUS(call) \
+    (begin_round_trip(), end_round_trip_status(__FILE__, __LINE__, (call)))
+
+/* latency indexes of all operations that are not events */
+typedef enum latency_operation {
+    /* event types come before the operations */
+    LATENCY_OPERATION_BEFORE_FIRST = LATENCY_EVENT_TYPES - 1,
+#define X(operation, name) operation,
+    DEFINE_ALL_LATENCY_OPERATIONS
+#undef X
+    LATENCY_MAX
+} latency_operation_t;
+
+/* Add the time from @start until now to the histogram at @index which is
+ * either an event type or a `latency_operation_t`.
+ *
+ * @return the current time so the next measurement can start from it.
+ */
+uint64_t record_latency(uint32_t index, uint64_t start);
+
+/* the action round trips are accounted to, this is `ACTION_NULL` outside of
+ * actions
+ */
+extern action_t round_trip_action;
+
+/* Start measuring a round trip, use `ROUND_TRIP()` instead. */
+void begin_round_trip(void);
+
+/* Account the round trip started by `begin_round_trip()` to @file and @line.
+ *
+ * @return @reply.
+ */
+void *end_round_trip(const char *file, int line, void *reply);
+
+/* Same as `end_round_trip()` but for a @status. */
+int end_round_trip_status(const char *file, int line, int status);
+
+/* Write all histograms that have any entries and the call sites and actions
+ * that blocked the longest on round trips to @file.
+ */
+void dump_latencies(FILE *file);
+
+#endif
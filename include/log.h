@@ -43,18 +43,60 @@ extern log_severity_t log_severity;
 
 #endif
 
+/* the least severity that is compiled in, logging below it is removed
+ * entirely, this can be set when building like
+ * `-DLOG_MINIMUM_SEVERITY=LOG_SEVERITY_ERROR`
+ */
+#ifndef LOG_MINIMUM_SEVERITY
+#define LOG_MINIMUM_SEVERITY LOG_SEVERITY_ALL
+#endif
+
+/* Log when @severity is compiled in and severe enough.
+ *
+ * The check happens before the arguments are evaluated so disabled logging
+ * costs a single comparison and logging below `LOG_MINIMUM_SEVERITY` is
+ * removed by the compiler.
+ */
+#define LOG_WITH_SEVERITY(severity, ...) do { \
+    if ((severity) >= LOG_MINIMUM_SEVERITY && log_severity <= (severity)) { \
+        log_formatted((severity), __FILE__, __LINE__, __VA_ARGS__); \
+    } \
+} while (0)
+
 /* wrappers around `log_formatted` for different severities */
-#define LOG_VERBOSE(...) \
-    log_formatted(LOG_SEVERITY_ALL, __FILE__, __LINE__, __VA_ARGS__)
-#define LOG(...) \
-    log_formatted(LOG_SEVERITY_INFO, __FILE__, __LINE__, __VA_ARGS__)
-#define LOG_ERROR(...) \
-    log_formatted(LOG_SEVERITY_ERROR, __FILE__, __LINE__, __VA_ARGS__)
+#define LOG_VERBOSE(...) LOG_WITH_SEVERITY(LOG_SEVERITY_ALL, __VA_ARGS__)
+#define LOG(...) LOG_WITH_SEVERITY(LOG_SEVERITY_INFO, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_WITH_SEVERITY(LOG_SEVERITY_ERROR, __VA_ARGS__)
+
+/* the number of bytes of log output that can be buffered before lines are
+ * dropped, this must be a power of two
+ */
+#define LOG_RING_SIZE (256 << 10)
+
+/* Start a thread that writes the log output to standard error output.
+ *
+ * Before this is called and after `deinitialize_logging()`, every line is
+ * written directly. While the thread runs, lines are buffered in a ring and
+ * written in large pieces, lines that do not fit into the ring are dropped and
+ * counted.
+ *
+ * Fatal paths going through `ABORT()` write out the buffered lines before the
+ * program aborts, see `flush_log_output()`.
+ *
+ * @return ERROR if the thread could not be created.
+ */
+int initialize_logging(void);
+
+/* Write out all buffered log output and stop the writer thread. */
+void deinitialize_logging(void);
 
 /* printf format specifiers that can be used */
 #define PRINTF_FORMAT_SPECIFIERS "diuoxfegcsp"
 
 /* Print a formatted string to standard error output.
+ *
+ * Each line is formatted in memory first and then written as a whole, see
+ * `initialize_logging()`.
  *
  * The following format specifiers are supported on top of the regular
  * format specifiers (some printf format specifiers might be overwritten):
@@ -75,4 +117,11 @@ extern log_severity_t log_severity;
 void log_formatted(log_severity_t severity, const char *file, int line,
         const char *format, ...);
 
+/* Print a formatted string to @file.
+ *
+ * This supports the same format specifiers as `log_formatted()` but prints no
+ * time and file in front.
+ */
+void print_formatted(FILE *file, const char *format, ...);
+
 #endif
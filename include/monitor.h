@@ -31,6 +31,11 @@ typedef struct monitor {
 /* the first monitor in the monitor linked list */
 extern Monitor *Monitor_first;
 
+/* if the monitor struts need to be recomputed, this is set when a dock window
+ * or the monitor configuration changes
+ */
+extern bool are_monitors_dirty;
+
 /* Try to initialize randr and the internal monitor linked list. */
 void initialize_monitors(void);
 
@@ -16,6 +16,19 @@
 
 #include "utf8.h"
 
+/* An off-screen pixmap that is drawn onto and then copied onto a window in one
+ * go, this avoids flickering.
+ */
+typedef struct back_buffer {
+    /* the window the buffer is presented on */
+    xcb_window_t window;
+    /* the off-screen pixmap or `XCB_NONE` if it was not created yet */
+    xcb_pixmap_t pixmap;
+    /* the size of the pixmap */
+    uint32_t width;
+    uint32_t height;
+} BackBuffer;
+
 /* the version of the underlying X renderer */
 extern struct xrender_version {
     uint32_t major;
@@ -47,6 +60,31 @@ xcb_render_pictformat_t find_visual_format(xcb_visualid_t visual);
 /* Get a good picture format for given depth. */
 xcb_render_pictformat_t get_picture_format(uint8_t depth);
 
+/* Make sure @buffer can hold at least @width times @height pixels.
+ *
+ * The pixmap only ever grows so that it is not recreated on every resize.
+ *
+ * @return true if a new pixmap was created, its content must be fully drawn
+ *         again.
+ */
+bool resize_back_buffer(BackBuffer *buffer, uint32_t width, uint32_t height);
+
+/* Fill @rectangle within the back buffer with a solid color. */
+void fill_back_buffer(BackBuffer *buffer, const xcb_rectangle_t *rectangle,
+        uint32_t color);
+
+/* Copy @rectangle of the back buffer onto the same region of its window. */
+void present_back_buffer(BackBuffer *buffer, const xcb_rectangle_t *rectangle);
+
+/* Free the pixmap of the back buffer. */
+void free_back_buffer(BackBuffer *buffer);
+
+/* Release the picture that was created for drawing onto @drawable.
+ *
+ * This must be called before freeing a drawable that was drawn onto.
+ */
+void release_drawable_picture(xcb_drawable_t drawable);
+
 /* Set the globally used font for rendering.
  *
  * @return OK on success or ERROR when the font was not found.
@@ -0,0 +1,86 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/**
+ * A compact binary trace of all X events and actions.
+ *
+ * When a trace file is given (`--trace FILE`), every handled event and every
+ * action is stored as a fixed size record in a memory mapped file. The file
+ * holds `TRACE_MAXIMUM_RECORDS` records and then wraps around so only the most
+ * recent records are kept. A previous trace at the same path is moved to
+ * "FILE.old" when tracing starts.
+ *
+ * A trace file is turned back into text with `--decode-trace FILE` which uses
+ * the same printers as the log.
+ */
+
+#include <stdint.h>
+
+#include <xcb/xcb.h>
+
+#include "action.h"
+
+/* the number of records a trace file holds before it wraps around */
+#define TRACE_MAXIMUM_RECORDS 65536
+
+/* the kind of a trace record */
+typedef enum trace_kind {
+    /* an X event was handled */
+    TRACE_KIND_EVENT,
+    /* an action was done */
+    TRACE_KIND_ACTION,
+} trace_kind_t;
+
+/* a single record within a trace file */
+typedef struct trace_record {
+    /* the time in nanoseconds since the trace started */
+    uint64_t time;
+    /* how long the handling took in nanoseconds */
+    uint32_t duration;
+    /* the focused window for events or the window an action was done on */
+    uint32_t window;
+    /* the number of the focused frame */
+    uint32_t frame;
+    /* the action code for actions */
+    uint16_t action;
+    /* the `trace_kind_t` of this record */
+    uint8_t kind;
+    /* the event type for events */
+    uint8_t event_type;
+    /* the raw event data for events */
+    uint8_t event[32];
+    /* pad to 64 bytes */
+    uint8_t padding[8];
+} TraceRecord;
+
+/* the path of the trace file or `NULL` if no trace should be written */
+extern char *trace_path;
+
+/* if a trace is currently written */
+extern bool is_tracing;
+
+/* Create the trace file at `trace_path`.
+ *
+ * This must be called after the atoms and randr are initialized as they are
+ * stored in the trace file.
+ *
+ * @return ERROR if the file could not be created.
+ */
+int initialize_trace(void);
+
+/* Unmap and close the trace file. */
+void deinitialize_trace(void);
+
+/* Add a record for an @event whose handling started at @start. */
+void trace_event(const xcb_generic_event_t *event, uint64_t start);
+
+/* Add a record for an @action done on @window that started at @start. */
+void trace_action(const Action *action, xcb_window_t window, uint64_t start);
+
+/* Print all records within the trace file at @path to standard output.
+ *
+ * @return ERROR if the file could not be read.
+ */
+int decode_trace(const char *path);
+
+#endif
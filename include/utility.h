@@ -17,8 +17,19 @@
 /* indicate integer error value */
 #define ERROR 1
 
-/* Abort the program after printing an error message. */
+/* Write out the log output still buffered for the writer thread right away.
+ *
+ * This is defined in log.c and is used on fatal paths.
+ */
+void flush_log_output(void);
+
+/* Abort the program after printing an error message.
+ *
+ * All buffered log output is written before the message so the lines leading
+ * up to the error are not lost.
+ */
 #define ABORT(message) do { \
+    flush_log_output(); \
     fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, (message)); \
     abort(); \
 } while (false)
@@ -41,7 +52,7 @@
 #endif
 
 /* Assert that statement @x is true. If this is not the case, the program is
- * aborted.
+ * aborted through `ABORT()`.
  */
 #define ASSERT(x, message) do { \
     if (UNLIKELY(!(x))) { \
@@ -162,6 +173,9 @@ typedef struct ratio {
     uint32_t denominator;
 } Ratio;
 
+/* Get the time of a monotonic clock in nanoseconds. */
+uint64_t get_monotonic_time(void);
+
 /* Get the length of @string up to a maximum of @max_length. */
 size_t strnlen(const char *string, size_t max_length);
 
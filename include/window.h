@@ -9,6 +9,7 @@
 #include "configuration.h"
 #include "monitor.h"
 #include "utility.h"
+#include "window_properties.h"
 #include "window_state.h"
 
 #include "x11_management.h"
@@ -37,6 +38,28 @@ struct window {
     /* window name */
     utf8_t *name;
 
+    /* the entry of this window within the window list, measuring text is
+     * expensive so it is only built again when the name, number or indicator
+     * changes
+     */
+    struct window_list_entry {
+        /* the text shown in the window list or NULL if it needs to be built */
+        utf8_t *text;
+        /* the length of the text in bytes */
+        uint32_t length;
+        /* the number and indicator character the text was built with */
+        uint32_t number;
+        char indicator;
+        /* the measured size of the text */
+        int32_t ascent;
+        uint32_t width;
+        uint32_t height;
+        /* if the current text is drawn within the back buffer of the window
+         * list
+         */
+        bool is_drawn;
+    } list_entry;
+
     /* X size hints of the window */
     xcb_size_hints_t size_hints;
 
@@ -81,6 +104,12 @@ struct window {
     /* the number of this window, multiple windows may have the same number */
     uint32_t number;
 
+    /* the frame this window is contained in, this is kept up to date by
+     * `set_frame_window()` and is NULL when the window is not part of the
+     * tiling layout, this includes being in a stashed frame
+     */
+    Frame *frame;
+
     /* All windows are part of the Z ordered linked list even when they are
      * hidden now.
      *
@@ -98,6 +127,14 @@ struct window {
     /* The number linked list stores the windows sorted by their number. */
     /* the next window in the linked list */
     Window *next;
+
+    /* The dirty linked list stores the windows that have changes not yet
+     * synchronized with the X server.
+     */
+    /* if the window is within the dirty linked list */
+    bool is_dirty;
+    /* the next window in the dirty linked list */
+    Window *next_dirty;
 };
 
 /* the number of all windows within the linked list, this value is kept up to
@@ -108,6 +145,9 @@ extern uint32_t Window_count;
 /* the window that was created before any other */
 extern Window *Window_oldest;
 
+/* the window that was created after all others */
+extern Window *Window_newest;
+
 /* the window at the bottom of the Z stack */
 extern Window *Window_bottom;
 
@@ -120,6 +160,9 @@ extern Window *Window_first;
 /* the currently focused window */
 extern Window *Window_focus;
 
+/* the first window in the dirty linked list */
+extern Window *Window_first_dirty;
+
 /* Increment the reference count of the window. */
 void reference_window(Window *window);
 
@@ -128,6 +171,33 @@ void reference_window(Window *window);
  */
 void dereference_window(Window *window);
 
+/* cookies of all requests needed for creating a window */
+struct window_requests {
+    /* the X window the requests were sent for */
+    xcb_window_t id;
+    /* the attributes of the window */
+    xcb_get_window_attributes_cookie_t attributes;
+    /* the size and position of the window */
+    xcb_get_geometry_cookie_t geometry;
+    /* all properties we care about */
+    struct window_property_cookies properties;
+};
+
+/* Send all requests needed to create a window for @xcb.
+ *
+ * This allows sending the requests for many windows before waiting for any
+ * reply, the window is then created with `create_window_from_replies()`.
+ */
+void send_window_requests(xcb_window_t xcb, struct window_requests *requests);
+
+/* Create a window object from the replies of @requests and add it to all
+ * window lists.
+ *
+ * @association is filled with any associations found belonging to the window.
+ */
+Window *create_window_from_replies(const struct window_requests *requests,
+        struct configuration_association *association);
+
 /* Create a window object and add it to all window lists.
  *
  * @association is filled with any associations found belonging to the window.
@@ -135,6 +205,20 @@ void dereference_window(Window *window);
 Window *create_window(xcb_window_t xcb,
         struct configuration_association *association);
 
+/* Mark the window as changed so that the next call to
+ * `synchronize_with_server()` applies its size, border, visibility and focus
+ * state.
+ *
+ * Changes to a dock window also mark the monitors as dirty because the strut
+ * might have changed.
+ */
+void mark_window_dirty(Window *window);
+
+/* Mark all windows as dirty, use this when a global setting like the border
+ * color changes.
+ */
+void mark_all_windows_dirty(void);
+
 /* Destroy given window and removes it from the window linked list.
  * This does NOT destroy the underlying X window.
  */
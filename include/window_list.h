@@ -1,12 +1,31 @@
 #ifndef WINDOW_LIST_H
 #define WINDOW_LIST_H
 
+#include "render.h"
 #include "window.h"
 
 /* user window list window */
 extern struct window_list {
     /* the X correspondence */
     XClient client;
+    /* the off-screen buffer the list is drawn onto */
+    BackBuffer buffer;
+    /* what each visible row showed when it was last drawn, this is used to
+     * only draw the rows that changed
+     */
+    struct window_list_row {
+        /* the window shown in the row, this is only compared and never
+         * dereferenced
+         */
+        Window *window;
+        /* if the row was drawn as selected row */
+        bool is_selected;
+    } *drawn_rows;
+    /* the number of rows in `drawn_rows` */
+    uint32_t number_of_drawn_rows;
+    /* the width and height of the rows when they were last drawn */
+    uint32_t drawn_width;
+    uint32_t drawn_height;
     /* the currently selected window */
     uint32_t selected;
     /* the currently scrolled amount */
@@ -18,6 +37,18 @@ extern struct window_list {
 /* Create the window list. */
 int initialize_window_list(void);
 
+/* Drop the cached window list entry of @window.
+ *
+ * This must be called when the name of the window changes.
+ */
+void invalidate_window_list_entry(Window *window);
+
+/* Drop the cached window list entries of all windows.
+ *
+ * This must be called when the font changes.
+ */
+void invalidate_all_window_list_entries(void);
+
 /* Handle an incoming event for the window list. */
 void handle_window_list_event(xcb_generic_event_t *event);
 
@@ -218,13 +218,56 @@ void initialize_root_properties(void);
 /* Gets the `FENSTERCHEF_COMMAND` property from @window. */
 char *get_fensterchef_command_property(xcb_window_t window);
 
-/* Initialize all properties within @window.
+/* cookies of all property requests sent for a window, this allows sending all
+ * requests at once and then collecting the replies with only a single round
+ * trip
+ */
+struct window_property_cookies {
+    /* `WM_CLASS` */
+    xcb_get_property_cookie_t class;
+    /* `_NET_WM_NAME` and its fallback `WM_NAME` */
+    xcb_get_property_cookie_t net_name;
+    xcb_get_property_cookie_t name;
+    /* `WM_NORMAL_HINTS` */
+    xcb_get_property_cookie_t size_hints;
+    /* `WM_HINTS` */
+    xcb_get_property_cookie_t hints;
+    /* `_NET_WM_STRUT_PARTIAL` and its fallback `_NET_WM_STRUT` */
+    xcb_get_property_cookie_t strut_partial;
+    xcb_get_property_cookie_t strut;
+    /* `WM_TRANSIENT_FOR` */
+    xcb_get_property_cookie_t transient_for;
+    /* `WM_PROTOCOLS` */
+    xcb_get_property_cookie_t protocols;
+    /* `_NET_WM_FULLSCREEN_MONITORS` */
+    xcb_get_property_cookie_t fullscreen_monitors;
+    /* `_MOTIF_WM_HINTS` */
+    xcb_get_property_cookie_t motif_wm_hints;
+    /* `_NET_WM_STATE` */
+    xcb_get_property_cookie_t states;
+    /* `_NET_WM_WINDOW_TYPE` */
+    xcb_get_property_cookie_t types;
+};
+
+/* Send the requests for all properties of @window we care about.
+ *
+ * The replies must be collected with `initialize_window_properties()` or
+ * thrown away with `discard_window_properties()`.
+ */
+void request_window_properties(xcb_window_t window,
+        struct window_property_cookies *cookies);
+
+/* Throw away the replies of all requests within @cookies. */
+void discard_window_properties(const struct window_property_cookies *cookies);
+
+/* Initialize all properties within @window from the replies of @cookies.
  *
  * @association is filled with any association found that relates to the window.
  *
  * @return the mode the window should be in initially.
  */
 window_mode_t initialize_window_properties(Window *window,
+        const struct window_property_cookies *cookies,
         struct configuration_association *association);
 
 /* Update the property within @window corresponding to given @atom. */
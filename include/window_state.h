@@ -94,7 +94,8 @@ void hide_window(Window *window);
  *
  * Note: The focus however is removed if @window is the focus.
  *
- * To abrubtly show a window, simply do: `window->state.is_visible = true`.
+ * To abrubtly show a window, simply do: `window->state.is_visible = true` and
+ * `mark_window_dirty(window)`.
  */
 void hide_window_abruptly(Window *window);
 
@@ -8,12 +8,15 @@
 #include "event.h"
 #include "fensterchef.h"
 #include "frame.h"
+#include "ipc.h"
+#include "latency.h"
 #include "log.h"
 #include "monitor.h"
 #include "move_frame.h"
 #include "size_frame.h"
 #include "stash_frame.h"
 #include "tiling.h"
+#include "trace.h"
 #include "utility.h"
 #include "window_list.h"
 
@@ -217,9 +220,10 @@ bool set_showable_tiling_window(uint32_t count, bool previous)
     /* clear the old frame and stash it */
     (void) stash_frame(Frame_focus);
     /* put the window into the focused frame, size and show it */
-    Frame_focus->window = valid_window;
+    set_frame_window(Frame_focus, valid_window);
     reload_frame(Frame_focus);
     valid_window->state.is_visible = true;
+    mark_window_dirty(valid_window);
     /* focus the shown window */
     set_focus_window(valid_window);
     return true;
@@ -418,8 +422,8 @@ static bool move_to_below_frame(Frame *relative, bool do_exchange)
     return true;
 }
 
-/* Do the given action. */
-bool do_action(const Action *action, Window *window)
+/* Run the code for the given action. */
+static bool dispatch_action(const Action *action, Window *window)
 {
     char *shell;
     int32_t count;
@@ -877,6 +881,11 @@ bool do_action(const Action *action, Window *window)
         break;
     }
 
+    /* write the latency histograms to the requester */
+    case ACTION_DUMP_LATENCIES:
+        dump_latencies(get_command_output());
+        break;
+
     /* quit fensterchef */
     case ACTION_QUIT:
         Fensterchef_is_running = false;
@@ -888,3 +897,33 @@ bool do_action(const Action *action, Window *window)
     }
     return true;
 }
+
+/* Do the given action. */
+bool do_action(const Action *action, Window *window)
+{
+    uint64_t start = 0;
+    xcb_window_t xcb_window = XCB_NONE;
+    action_t previous_action;
+    bool result;
+
+    /* remember the id, the window might be gone after the action */
+    if (is_tracing) {
+        start = get_monotonic_time();
+        if (window != NULL) {
+            xcb_window = window->client.id;
+        }
+    }
+
+    /* account all round trips in between to this action, actions can run
+     * other actions so restore the previous one afterwards
+     */
+    previous_action = round_trip_action;
+    round_trip_action = action->code;
+
+    result = dispatch_action(action, window);
+
+    round_trip_action = previous_action;
+
+    trace_action(action, xcb_window, start);
+    return result;
+}
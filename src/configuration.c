@@ -323,18 +323,18 @@ void set_configuration(struct configuration *new_configuration)
     if (configuration.font.name != NULL) {
         set_modern_font(configuration.font.name);
     }
+    /* the window list entries were measured with the old font */
+    invalidate_all_window_list_entries();
 
-    /* refresh the border size and color of all windows */
+    /* refresh the border size of all windows, the border color is refreshed
+     * when synchronizing
+     */
     for (Window *window = Window_first; window != NULL; window = window->next) {
-        if (window == Window_focus) {
-            window->border_color = configuration.border.focus_color;
-        } else {
-            window->border_color = configuration.border.color;
-        }
         if (!is_window_borderless(window)) {
             window->border_size = configuration.border.size;
         }
     }
+    mark_all_windows_dirty();
 
     /* reload all frames since the gaps or border sizes might have changed */
     for (Monitor *monitor = Monitor_first; monitor != NULL;
@@ -1,5 +1,11 @@
+#include <dirent.h>
+#include <fcntl.h>
 #include <inttypes.h>
+#include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <xcb/xcb_image.h>
 
@@ -24,6 +30,13 @@ const char *xcursor_core_strings[XCURSOR_MAX] = {
 #undef X
 };
 
+/* translation of filter to string */
+static const char *xcursor_filter_strings[XCURSOR_FILTER_MAX] = {
+#define X(constant, string) [constant] = string,
+    DEFINE_ALL_XCURSOR_FILTERS
+#undef X
+};
+
 /* translation of error to string */
 const char *xcursor_error_strings[XCURSOR_ERROR_MAX] = {
 #define X(code, string) [code] = string,
@@ -42,6 +55,30 @@ core_cursor_t string_to_cursor(const char *string)
     return XCURSOR_MAX;
 }
 
+/* Translate a string to a filter constant. */
+xcursor_filter_t string_to_xcursor_filter(const char *string)
+{
+    for (xcursor_filter_t i = 0; i < XCURSOR_FILTER_MAX; i++) {
+        if (strcasecmp(xcursor_filter_strings[i], string) == 0) {
+            return i;
+        }
+    }
+    return XCURSOR_FILTER_MAX;
+}
+
+/* Set the filter used for resizing cursors from its name. */
+void set_xcursor_filter(const char *name)
+{
+    xcursor_filter_t filter;
+
+    filter = string_to_xcursor_filter(name);
+    if (filter == XCURSOR_FILTER_MAX) {
+        LOG_ERROR("invalid cursor filter: %s\n", name);
+        return;
+    }
+    xcursor_settings.filter = filter;
+}
+
 /* Loosely convert a string to a boolean. */
 bool xcursor_string_to_boolean(const char *string)
 {
@@ -72,6 +109,7 @@ void set_default_xcursor_settings(void)
     free(xcursor_settings.path);
     xcursor_settings.path = xstrdup(XCURSOR_DEFAULT_PATH);
     xcursor_settings.resized = false;
+    xcursor_settings.filter = XCURSOR_FILTER_SMOOTH;
     xcursor_settings.size = 0;
     xcursor_settings.theme = NULL;
     xcursor_settings.theme_core = false;
@@ -106,6 +144,11 @@ void overwrite_xcursor_settings(void)
         xcursor_settings.resized = xcursor_string_to_boolean(variable);
     }
 
+    variable = getenv("XCURSOR_FILTER");
+    if (variable != NULL) {
+        set_xcursor_filter(variable);
+    }
+
     variable = getenv("XCURSOR_SIZE");
     if (variable != NULL) {
         xcursor_settings.size = strtol(variable, NULL, 10);
@@ -123,52 +166,66 @@ void overwrite_xcursor_settings(void)
     }
 }
 
-/* Read a 32 byte large integer from @file in little endianness format. */
-static bool read32(FILE *file, uint32_t *destination)
+/* Get the 32 bit integer stored in little endianness format at @bytes. */
+static inline uint32_t get_little_endian32(const uint8_t *bytes)
 {
-    uint8_t bytes[4];
-
-    if (fread(bytes, 1, sizeof(bytes), file) != sizeof(bytes)) {
-        return false;
-    }
-    *destination = (bytes[3] << 24) | (bytes[2] << 16) | (bytes[1] << 8) |
-        bytes[0];
-    return true;
+    return ((uint32_t) bytes[3] << 24) | ((uint32_t) bytes[2] << 16) |
+        ((uint32_t) bytes[1] << 8) | bytes[0];
 }
 
-/* Skip over a comment chunk. */
-xcursor_error_t skip_comment_chunk(FILE *file, uint32_t subtype)
+/* Copy @count 32 bit integers stored in little endianness format. */
+static void copy_little_endian32(uint32_t *destination, const uint8_t *source,
+        uint32_t count)
 {
-    struct xcursor_comment_header header;
-
-    /* read the length */
-    if (!read32(file, &header.length)) {
-        return XCURSOR_ERROR_INVALID_COMMENT_CHUNK;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    /* the format already matches */
+    memcpy(destination, source, (size_t) count * sizeof(*destination));
+#else
+    /* the compiler turns this into vectorized byte swaps */
+    for (uint32_t i = 0; i < count; i++) {
+        destination[i] = get_little_endian32(&source[i * 4]);
     }
+#endif
+}
 
-    /* the sub type should be one of:
-     * 1 (COPYRIGHT)
-     * 2 (LICENSE)
-     * 3 (OTHER)
-     */
-    if (subtype < 1 || subtype > 3) {
-        return XCURSOR_ERROR_INVALID_COMMENT_SUBTYPE;
+/* Read the chunk header at @position within @data.
+ *
+ * @return false if the chunk header is not within @size.
+ */
+static bool get_chunk_header(const uint8_t *data, size_t size,
+        uint32_t position, struct xcursor_chunk_header *header)
+{
+    if (position > size || size - position < 4 * 4) {
+        return false;
     }
-
-    /* skip the comment string */
-    fseek(file, header.length, SEEK_CUR);
-
-    return XCURSOR_SUCCESS;
+    data += position;
+    header->header = get_little_endian32(&data[0]);
+    header->type = get_little_endian32(&data[4]);
+    header->subtype = get_little_endian32(&data[8]);
+    header->version = get_little_endian32(&data[12]);
+    return true;
 }
 
-/* Load an image chunk from @file. */
-xcursor_error_t load_cursor_image(FILE *file, struct xcursor_image *image)
+/* Load the image chunk at @position within @data. */
+static xcursor_error_t load_cursor_image(const uint8_t *data, size_t size,
+        uint32_t position, struct xcursor_image *image)
 {
-    /* read image size */
-    if (!read32(file, &image->header.width) ||
-            !read32(file, &image->header.height)) {
+    size_t offset;
+    uint32_t length;
+
+    /* skip over the chunk header, it was checked already */
+    offset = (size_t) position + 4 * 4;
+
+    /* read image size, hotspot and delay */
+    if (size - offset < 4 * 5) {
         return XCURSOR_ERROR_INVALID_IMAGE_CHUNK;
     }
+    image->header.width = get_little_endian32(&data[offset]);
+    image->header.height = get_little_endian32(&data[offset + 4]);
+    image->header.xhot = get_little_endian32(&data[offset + 8]);
+    image->header.yhot = get_little_endian32(&data[offset + 12]);
+    image->header.delay = get_little_endian32(&data[offset + 16]);
+    offset += 4 * 5;
 
     /* check the image bounds */
     if (image->header.width >= XCURSOR_MAX_IMAGE_SIZE ||
@@ -176,54 +233,44 @@ xcursor_error_t load_cursor_image(FILE *file, struct xcursor_image *image)
         return XCURSOR_ERROR_IMAGE_TOO_LARGE;
     }
 
-    /* read the hotspot */
-    if (!read32(file, &image->header.xhot) ||
-            !read32(file, &image->header.yhot)) {
-        return XCURSOR_ERROR_INVALID_IMAGE_CHUNK;
-    }
-
     /* confirm that the hotspot is in bound */
     if (image->header.xhot >= image->header.width ||
             image->header.yhot >= image->header.height) {
         return XCURSOR_ERROR_INVALID_IMAGE_HOTSPOT;
     }
 
-    /* read the delay */
-    if (!read32(file, &image->header.delay)) {
-        return XCURSOR_ERROR_INVALID_IMAGE_CHUNK;
+    /* read the pixels all at once */
+    length = image->header.width * image->header.height;
+    if ((size - offset) / sizeof(uint32_t) < length) {
+        return XCURSOR_ERROR_MISSING_IMAGE_DATA;
     }
-
-    /* read the pixels */
-    const uint32_t length = image->header.width * image->header.height;
     image->pixels = xreallocarray(NULL, length, sizeof(uint32_t));
-    for (uint32_t i = 0; i < length; i++) {
-        if (!read32(file, &image->pixels[i])) {
-            free(image->pixels);
-            return XCURSOR_ERROR_MISSING_IMAGE_DATA;
-        }
-    }
-
+    copy_little_endian32(image->pixels, &data[offset], length);
     return XCURSOR_SUCCESS;
 }
 
-/* Read a file as cursor file. */
-xcursor_error_t load_cursor_file(FILE *file, struct xcursor_file *xcursor)
+/* Load the images of the size closest to @size from the mapped cursor file
+ * @data.
+ */
+static xcursor_error_t load_cursor_data(const uint8_t *data, size_t size,
+        uint32_t target_size, struct xcursor_file *xcursor)
 {
-    xcursor_error_t error = XCURSOR_SUCCESS;
-
     struct xcursor_header header;
-
+    struct xcursor_entry *entries;
+    struct xcursor_chunk_header chunk_header;
+    bool has_best_size = false;
+    uint32_t best_size = 0;
     uint32_t number_of_images = 0;
-
-    memset(xcursor, 0, sizeof(*xcursor));
+    xcursor_error_t error = XCURSOR_SUCCESS;
 
     /* read the header */
-    if (!read32(file, &header.magic) ||
-            !read32(file, &header.header) ||
-            !read32(file, &header.version) ||
-            !read32(file, &header.number_of_entries)) {
+    if (size < 4 * 4) {
         return XCURSOR_ERROR_INVALID_FILE;
     }
+    header.magic = get_little_endian32(&data[0]);
+    header.header = get_little_endian32(&data[4]);
+    header.version = get_little_endian32(&data[8]);
+    header.number_of_entries = get_little_endian32(&data[12]);
 
     /* confirm the magic */
     if (header.magic != XCURSOR_MAGIC) {
@@ -232,85 +279,140 @@ xcursor_error_t load_cursor_file(FILE *file, struct xcursor_file *xcursor)
 
     /* TODO: confirm the version, I think it should be 0x10000 */
 
-    /* read entries from the table of contents */
-    struct xcursor_entry entries[header.number_of_entries];
-    for (uint32_t i = 0; i < header.number_of_entries; i++) {
-        struct xcursor_entry *const entry = &entries[i];
-        if (!read32(file, &entry->type) ||
-                !read32(file, &entry->subtype) ||
-                !read32(file, &entry->position)) {
-            error = XCURSOR_ERROR_MISSING_TABLE_OF_CONTENTS;
-            break;
-        }
-        number_of_images++;
-    }
-
-    if (number_of_images == 0) {
-        error = XCURSOR_ERROR_FILE_WITHOUT_IMAGES;
+    /* the table of contents follows the header */
+    if ((size - 4 * 4) / (4 * 3) < header.number_of_entries) {
+        return XCURSOR_ERROR_MISSING_TABLE_OF_CONTENTS;
     }
 
-    /* allocate enough space to hold onto all images */
-    RESIZE(xcursor->images, number_of_images);
+    /* read and validate all entries from the table of contents and find the
+     * best fitting size
+     */
+    entries = xreallocarray(NULL, header.number_of_entries, sizeof(*entries));
+    for (uint32_t i = 0; i < header.number_of_entries; i++) {
+        struct xcursor_entry *const entry = &entries[i];
 
-    /* read the chunks */
-    for (uint32_t i = 0;
-            error == XCURSOR_SUCCESS && i < header.number_of_entries;
-            i++) {
-        struct xcursor_chunk_header chunk_header;
+        entry->type = get_little_endian32(&data[4 * 4 + i * 4 * 3]);
+        entry->subtype = get_little_endian32(&data[4 * 4 + i * 4 * 3 + 4]);
+        entry->position = get_little_endian32(&data[4 * 4 + i * 4 * 3 + 8]);
 
-        /* seek to the chunk */
-        if (fseek(file, entries[i].position, SEEK_SET) == EOF) {
+        if (!get_chunk_header(data, size, entry->position, &chunk_header)) {
             error = XCURSOR_ERROR_MISSING_CHUNK;
             break;
         }
 
-        /* read the chunk header */
-        if (!read32(file, &chunk_header.header) ||
-                !read32(file, &chunk_header.type) ||
-                !read32(file, &chunk_header.subtype)) {
-            error = XCURSOR_ERROR_INVALID_CHUNK_HEADER;
-            break;
-        }
-
         /* these must match says the specification */
-        if (chunk_header.type != entries[i].type ||
-                chunk_header.subtype != entries[i].subtype) {
+        if (chunk_header.type != entry->type ||
+                chunk_header.subtype != entry->subtype) {
             error = XCURSOR_ERROR_INVALID_CHUNK_HEADER;
             break;
         }
 
         /* confirm the version */
-        if (!read32(file, &chunk_header.version)) {
-            error = XCURSOR_ERROR_INVALID_CHUNK_HEADER;
-            break;
-        }
         if (chunk_header.version != XCURSOR_CHUNK_VERSION) {
             error = XCURSOR_ERROR_UNSUPPORTED_CHUNK_VERSION;
             break;
         }
 
-        switch (chunk_header.type) {
-        /* ignore comment chunks */
+        switch (entry->type) {
+        /* comment chunks are ignored but the sub type should be one of:
+         * 1 (COPYRIGHT)
+         * 2 (LICENSE)
+         * 3 (OTHER)
+         */
         case XCURSOR_COMMENT_TYPE:
-            error = skip_comment_chunk(file, chunk_header.subtype);
+            if (entry->subtype < 1 || entry->subtype > 3) {
+                error = XCURSOR_ERROR_INVALID_COMMENT_SUBTYPE;
+            }
+            break;
+
+        /* the sub type of image chunks is their size, images without size
+         * can not be scaled and are skipped
+         */
+        case XCURSOR_IMAGE_TYPE:
+            if (entry->subtype == 0) {
+                break;
+            }
+            if (!has_best_size ||
+                    ABSOLUTE_DIFFERENCE(entry->subtype, target_size) <
+                        ABSOLUTE_DIFFERENCE(best_size, target_size)) {
+                has_best_size = true;
+                best_size = entry->subtype;
+                number_of_images = 0;
+            }
+            if (entry->subtype == best_size) {
+                number_of_images++;
+            }
+            break;
+        }
+
+        if (error != XCURSOR_SUCCESS) {
             break;
+        }
+    }
+
+    if (error == XCURSOR_SUCCESS && number_of_images == 0) {
+        error = XCURSOR_ERROR_FILE_WITHOUT_IMAGES;
+    }
 
-        /* load image chunks */
-        case XCURSOR_IMAGE_TYPE: {
+    /* only decode the images of the best fitting size */
+    if (error == XCURSOR_SUCCESS) {
+        xcursor->images = xreallocarray(NULL, number_of_images,
+                sizeof(*xcursor->images));
+        for (uint32_t i = 0; i < header.number_of_entries &&
+                xcursor->number_of_images < number_of_images; i++) {
             struct xcursor_image *image;
 
+            if (entries[i].type != XCURSOR_IMAGE_TYPE ||
+                    entries[i].subtype != best_size) {
+                continue;
+            }
+
             image = &xcursor->images[xcursor->number_of_images];
-            image->size = chunk_header.subtype;
-            error = load_cursor_image(file, image);
+            image->size = best_size;
+            error = load_cursor_image(data, size, entries[i].position, image);
             if (error != XCURSOR_SUCCESS) {
                 break;
             }
             xcursor->number_of_images++;
-            break;
-        }
         }
     }
 
+    free(entries);
+    return error;
+}
+
+/* Read a file as cursor file. */
+xcursor_error_t load_cursor_file(const char *path, uint32_t size,
+        struct xcursor_file *xcursor)
+{
+    int file;
+    struct stat file_stat;
+    uint8_t *data;
+    xcursor_error_t error;
+
+    memset(xcursor, 0, sizeof(*xcursor));
+
+    file = open(path, O_RDONLY);
+    if (file < 0) {
+        return XCURSOR_ERROR_INVALID_FILE;
+    }
+
+    if (fstat(file, &file_stat) < 0 || file_stat.st_size == 0) {
+        close(file);
+        return XCURSOR_ERROR_INVALID_FILE;
+    }
+
+    /* map the entire file so that the images can be copied in one go */
+    data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED) {
+        return XCURSOR_ERROR_INVALID_FILE;
+    }
+
+    error = load_cursor_data(data, file_stat.st_size, size, xcursor);
+
+    munmap(data, file_stat.st_size);
+
     if (error != XCURSOR_SUCCESS) {
         clear_cursor_file(xcursor);
     }
@@ -413,20 +515,159 @@ static char *get_theme_inherits(const char *file_path)
 /* how many times to go deeper into inherited theme files */
 #define XCURSOR_MAX_INHERITS_DEPTH 128
 
-/* Find the cursor named @name within theme named @theme.
+/* the minimum number of slots in the theme index */
+#define XCURSOR_INDEX_MINIMUM_CAPACITY 256
+
+/* a cursor file found within a theme */
+struct cursor_theme_entry {
+    /* the name of the cursor, NULL marks an empty slot */
+    char *name;
+    /* the path of the cursor file */
+    char *path;
+};
+
+/* Index of all cursor files within the configured theme, the default theme and
+ * all themes they inherit from. It is built when the first cursor is loaded
+ * and cleared by `clear_cursor_cache()`.
+ *
+ * This is a hash map using open addressing with linear probing. The capacity
+ * is always a power of two and at most half of the slots are in use.
+ */
+static struct cursor_theme_index {
+    /* if the index was built */
+    bool is_built;
+    /* the slots of the hash map */
+    struct cursor_theme_entry *entries;
+    /* the number of slots in `entries` */
+    uint32_t capacity;
+    /* the number of used slots in `entries` */
+    uint32_t count;
+    /* the number of bits to shift the hash to the right so that it fits into
+     * the capacity
+     */
+    uint32_t shift;
+    /* the names of the themes that were scanned, so that no theme is scanned
+     * twice
+     */
+    char **themes;
+    uint32_t number_of_themes;
+} theme_index;
+
+/* Find the slot of the cursor named @name within the theme index.
+ *
+ * @return the slot holding @name or the empty slot it would go into.
+ */
+static struct cursor_theme_entry *find_theme_entry(const char *name)
+{
+    uint32_t hash;
+    uint32_t index;
+
+    /* FNV-1a hash spread out by Fibonacci hashing */
+    hash = UINT32_C(2166136261);
+    for (const char *c = name; c[0] != '\0'; c++) {
+        hash ^= (uint8_t) c[0];
+        hash *= UINT32_C(16777619);
+    }
+    index = (uint32_t) (hash * UINT32_C(2654435769)) >> theme_index.shift;
+
+    while (theme_index.entries[index].name != NULL &&
+            strcmp(theme_index.entries[index].name, name) != 0) {
+        index = (index + 1) & (theme_index.capacity - 1);
+    }
+    return &theme_index.entries[index];
+}
+
+/* Double the capacity of the theme index and rehash all entries. */
+static void grow_theme_index(void)
+{
+    struct cursor_theme_entry *old_entries;
+    uint32_t old_capacity;
+
+    old_entries = theme_index.entries;
+    old_capacity = theme_index.capacity;
+
+    if (theme_index.capacity == 0) {
+        theme_index.capacity = XCURSOR_INDEX_MINIMUM_CAPACITY;
+        theme_index.shift = 32;
+        for (uint32_t i = theme_index.capacity; i > 1; i >>= 1) {
+            theme_index.shift--;
+        }
+    } else {
+        theme_index.capacity *= 2;
+        theme_index.shift--;
+    }
+    theme_index.entries = xcalloc(theme_index.capacity,
+            sizeof(*theme_index.entries));
+
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        if (old_entries[i].name != NULL) {
+            *find_theme_entry(old_entries[i].name) = old_entries[i];
+        }
+    }
+    free(old_entries);
+}
+
+/* Add all cursor files within @directory to the theme index that are not in
+ * it already.
+ */
+static void scan_cursor_directory(const char *directory)
+{
+    DIR *dir;
+    struct dirent *entry;
+    struct cursor_theme_entry *slot;
+
+    dir = opendir(directory);
+    if (dir == NULL) {
+        return;
+    }
+
+    while (entry = readdir(dir), entry != NULL) {
+        /* skip hidden files and the "." and ".." entries */
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+
+        /* keep the load factor at or below 1/2 */
+        if ((theme_index.count + 1) * 2 > theme_index.capacity) {
+            grow_theme_index();
+        }
+
+        /* earlier themes and paths take precedence */
+        slot = find_theme_entry(entry->d_name);
+        if (slot->name != NULL) {
+            continue;
+        }
+        slot->name = xstrdup(entry->d_name);
+        slot->path = xasprintf("%s/%s", directory, entry->d_name);
+        theme_index.count++;
+    }
+
+    closedir(dir);
+}
+
+/* Add all cursors within the theme named @theme and the themes it inherits
+ * from to the theme index.
  *
  * Call this with @inherit_depth set to 0.
  */
-static FILE *open_cursor_file(const char *theme, const char *name,
-        uint32_t inherit_depth, char **pointer_path)
+static void scan_cursor_theme(const char *theme, uint32_t inherit_depth)
 {
-    FILE *file = NULL;
     char *inherits = NULL;
     const char *path, *separator;
 
-    /* go over all paths and try to find the theme and cursor name */
-    for (path = xcursor_settings.path;
-            path != NULL && file == NULL;
+    /* a theme that was scanned already adds nothing new, this also avoids
+     * cycles
+     */
+    for (uint32_t i = 0; i < theme_index.number_of_themes; i++) {
+        if (strcmp(theme_index.themes[i], theme) == 0) {
+            return;
+        }
+    }
+    RESIZE(theme_index.themes, theme_index.number_of_themes + 1);
+    theme_index.themes[theme_index.number_of_themes++] = xstrdup(theme);
+
+    /* go over all paths and add the cursors of the theme */
+    for (path = xcursor_settings.path; path != NULL;
             path = (separator != NULL ? separator + 1 : NULL)) {
         char *theme_directory;
         char *full;
@@ -441,16 +682,12 @@ static FILE *open_cursor_file(const char *theme, const char *name,
         } else {
             theme_directory = xasprintf("%.*s/%s", path_length, path, theme);
         }
-        full = xasprintf("%s/cursors/%s", theme_directory, name);
-        file = fopen(full, "r");
-        if (file != NULL) {
-            *pointer_path = full;
-        } else {
-            free(full);
-        }
+        full = xasprintf("%s/cursors", theme_directory);
+        scan_cursor_directory(full);
+        free(full);
 
         /* themes can inherit data from other themes */
-        if (file == NULL && inherits == NULL) {
+        if (inherits == NULL) {
             full = xasprintf("%s/index.theme", theme_directory);
             inherits = get_theme_inherits(full);
             free(full);
@@ -458,28 +695,264 @@ static FILE *open_cursor_file(const char *theme, const char *name,
         free(theme_directory);
     }
 
-    /* avoid recursing through theme files if there is a cycle */
     if (inherit_depth < XCURSOR_MAX_INHERITS_DEPTH) {
-        /* check the inherited files */
-        for (path = inherits;
-                path != NULL && file == NULL;
-                separator = strchr(path, ':'),
-                    path = separator == NULL ? NULL : separator + 1) {
-            file = open_cursor_file(path, name, inherit_depth + 1,
-                    pointer_path);
+        /* add the cursors of the inherited themes */
+        for (path = inherits; path != NULL;
+                path = separator == NULL ? NULL : separator + 1) {
+            separator = strchr(path, ':');
+            char *const inherited = separator == NULL ? xstrdup(path) :
+                xstrndup(path, separator - path);
+            scan_cursor_theme(inherited, inherit_depth + 1);
+            free(inherited);
         }
     }
 
     free(inherits);
+}
+
+/* Find the cursor file named @name within the preferred theme or the default
+ * theme.
+ *
+ * @return the path of the cursor file or NULL if it was not found.
+ */
+static const char *find_cursor_file(const char *name)
+{
+    struct cursor_theme_entry *entry;
+
+    if (!theme_index.is_built) {
+        if (xcursor_settings.theme != NULL) {
+            scan_cursor_theme(xcursor_settings.theme, 0);
+        }
+        scan_cursor_theme("default", 0);
+        theme_index.is_built = true;
+
+        LOG("indexed %" PRIu32 " cursors within %" PRIu32 " themes\n",
+                theme_index.count, theme_index.number_of_themes);
+    }
+
+    if (theme_index.count == 0) {
+        return NULL;
+    }
+
+    entry = find_theme_entry(name);
+    return entry->path;
+}
+
+/* Clear the theme index so it is built again on the next cursor load. */
+static void clear_cursor_theme_index(void)
+{
+    for (uint32_t i = 0; i < theme_index.capacity; i++) {
+        free(theme_index.entries[i].name);
+        free(theme_index.entries[i].path);
+    }
+    free(theme_index.entries);
+    for (uint32_t i = 0; i < theme_index.number_of_themes; i++) {
+        free(theme_index.themes[i]);
+    }
+    free(theme_index.themes);
+    memset(&theme_index, 0, sizeof(theme_index));
+}
+
+/* tables and memory reused while scaling all images of a cursor */
+struct cursor_scaler {
+    /* the filter to use, this is never `XCURSOR_FILTER_SMOOTH` */
+    xcursor_filter_t filter;
+    /* the source and destination size the tables were computed for */
+    uint32_t source_width;
+    uint32_t source_height;
+    uint32_t width;
+    uint32_t height;
+    /* For each destination column and row:
+     * the first source pixel;
+     * the second source pixel when interpolating linearly, otherwise the
+     * number of source pixels covered;
+     * the weight of the second source pixel in 1/256 when interpolating
+     * linearly.
+     */
+    uint32_t *x_first, *x_second, *x_weight;
+    uint32_t *y_first, *y_second, *y_weight;
+    /* 65536 divided by the number of source pixels covered by a destination
+     * pixel, indexed by that number (box filter only)
+     */
+    uint32_t *reciprocals;
+    /* the scaled pixels */
+    uint32_t *pixels;
+};
+
+/* Fill the scaling tables mapping @length destination pixels to
+ * @source_length source pixels.
+ */
+static void fill_scale_table(xcursor_filter_t filter, uint32_t source_length,
+        uint32_t length, uint32_t *first, uint32_t *second, uint32_t *weight)
+{
+    int64_t position;
+
+    for (uint32_t i = 0; i < length; i++) {
+        switch (filter) {
+        case XCURSOR_FILTER_SMOOTH:
+        case XCURSOR_FILTER_NEAREST:
+        case XCURSOR_FILTER_MAX:
+            first[i] = (uint64_t) i * source_length / length;
+            second[i] = first[i];
+            weight[i] = 0;
+            break;
+
+        case XCURSOR_FILTER_BILINEAR:
+            /* the center of the destination pixel within the source in 1/256
+             * pixels
+             */
+            position = (int64_t) (2 * i + 1) * source_length * 128 / length -
+                128;
+            position = MAX(position, 0);
+            first[i] = position >> 8;
+            weight[i] = position & 0xff;
+            if (first[i] >= source_length - 1) {
+                first[i] = source_length - 1;
+                weight[i] = 0;
+            }
+            second[i] = MIN(first[i] + 1, source_length - 1);
+            break;
+
+        case XCURSOR_FILTER_BOX:
+            first[i] = (uint64_t) i * source_length / length;
+            second[i] = (uint64_t) (i + 1) * source_length / length - first[i];
+            second[i] = MAX(second[i], 1);
+            weight[i] = 0;
+            break;
+        }
+    }
+}
+
+/* Prepare @scaler to scale images of given size. */
+static void prepare_cursor_scaler(struct cursor_scaler *scaler,
+        uint32_t source_width, uint32_t source_height,
+        uint32_t width, uint32_t height)
+{
+    uint32_t maximum_area;
+
+    if (scaler->source_width == source_width &&
+            scaler->source_height == source_height &&
+            scaler->width == width && scaler->height == height) {
+        return;
+    }
+
+    RESIZE(scaler->x_first, width);
+    RESIZE(scaler->x_second, width);
+    RESIZE(scaler->x_weight, width);
+    RESIZE(scaler->y_first, height);
+    RESIZE(scaler->y_second, height);
+    RESIZE(scaler->y_weight, height);
+    RESIZE(scaler->pixels, width * height);
+
+    fill_scale_table(scaler->filter, source_width, width,
+            scaler->x_first, scaler->x_second, scaler->x_weight);
+    fill_scale_table(scaler->filter, source_height, height,
+            scaler->y_first, scaler->y_second, scaler->y_weight);
+
+    if (scaler->filter == XCURSOR_FILTER_BOX) {
+        maximum_area = (source_width / width + 1) *
+            (source_height / height + 1);
+        RESIZE(scaler->reciprocals, maximum_area + 1);
+        for (uint32_t i = 1; i <= maximum_area; i++) {
+            scaler->reciprocals[i] = 65536 / i;
+        }
+    }
+
+    scaler->source_width = source_width;
+    scaler->source_height = source_height;
+    scaler->width = width;
+    scaler->height = height;
+}
+
+/* Blend two premultiplied ARGB pixels, @weight is the weight of @second in
+ * 1/256.
+ */
+static inline uint32_t blend_pixels(uint32_t first, uint32_t second,
+        uint32_t weight)
+{
+    uint32_t red_blue, alpha_green;
+
+    /* blend two channels at once, each has 16 bits of room */
+    red_blue = ((first & 0xff00ff) * (256 - weight) +
+            (second & 0xff00ff) * weight) >> 8;
+    alpha_green = ((first >> 8) & 0xff00ff) * (256 - weight) +
+            ((second >> 8) & 0xff00ff) * weight;
+    return (red_blue & 0xff00ff) | (alpha_green & 0xff00ff00);
+}
+
+/* Scale @image with the box filter into the scaler pixels. */
+static void scale_box(struct cursor_scaler *scaler,
+        const struct xcursor_image *image)
+{
+    const uint32_t *row;
+    uint32_t pixel;
+    uint32_t sums[4];
+    uint32_t reciprocal;
+
+    for (uint32_t y = 0; y < scaler->height; y++) {
+        for (uint32_t x = 0; x < scaler->width; x++) {
+            sums[0] = 0;
+            sums[1] = 0;
+            sums[2] = 0;
+            sums[3] = 0;
+            for (uint32_t j = 0; j < scaler->y_second[y]; j++) {
+                row = &image->pixels[(scaler->y_first[y] + j) *
+                    image->header.width + scaler->x_first[x]];
+                for (uint32_t i = 0; i < scaler->x_second[x]; i++) {
+                    pixel = row[i];
+                    sums[0] += pixel & 0xff;
+                    sums[1] += (pixel >> 8) & 0xff;
+                    sums[2] += (pixel >> 16) & 0xff;
+                    sums[3] += pixel >> 24;
+                }
+            }
 
-    return file;
+            reciprocal = scaler->reciprocals[scaler->x_second[x] *
+                scaler->y_second[y]];
+            scaler->pixels[y * scaler->width + x] =
+                ((sums[0] * reciprocal + 32768) >> 16) |
+                ((sums[1] * reciprocal + 32768) >> 16) << 8 |
+                ((sums[2] * reciprocal + 32768) >> 16) << 16 |
+                ((sums[3] * reciprocal + 32768) >> 16) << 24;
+        }
+    }
+}
+
+/* Scale @image with the bilinear or nearest filter into the scaler pixels. */
+static void scale_linear(struct cursor_scaler *scaler,
+        const struct xcursor_image *image)
+{
+    const uint32_t *top, *bottom;
+    uint32_t *destination;
+    uint32_t upper, lower;
+
+    for (uint32_t y = 0; y < scaler->height; y++) {
+        top = &image->pixels[scaler->y_first[y] * image->header.width];
+        bottom = &image->pixels[scaler->y_second[y] * image->header.width];
+        destination = &scaler->pixels[y * scaler->width];
+        /* the weights are all zero for the nearest filter which makes this
+         * copy the first pixel
+         */
+        for (uint32_t x = 0; x < scaler->width; x++) {
+            upper = blend_pixels(top[scaler->x_first[x]],
+                    top[scaler->x_second[x]], scaler->x_weight[x]);
+            lower = blend_pixels(bottom[scaler->x_first[x]],
+                    bottom[scaler->x_second[x]], scaler->x_weight[x]);
+            destination[x] = blend_pixels(upper, lower, scaler->y_weight[y]);
+        }
+    }
 }
 
-/* Upscale given image to given size @new_size. */
-static void scale_cursor_image(struct xcursor_image *image, uint32_t new_size)
+/* Scale @image to the size @new_size.
+ *
+ * @scaled is set to the scaled image, its pixels are owned by @scaler and are
+ *         overwritten by the next call.
+ */
+static void scale_cursor_image(struct cursor_scaler *scaler,
+        const struct xcursor_image *image, uint32_t new_size,
+        struct xcursor_image *scaled)
 {
     uint32_t new_width, new_height;
-    uint32_t *new_pixels;
 
     new_width = (uint32_t) (image->header.width * new_size / image->size);
     new_height = (uint32_t) (image->header.height * new_size / image->size);
@@ -489,32 +962,35 @@ static void scale_cursor_image(struct xcursor_image *image, uint32_t new_size)
     new_width = MIN(new_width, XCURSOR_MAX_IMAGE_SIZE);
     new_height = MIN(new_height, XCURSOR_MAX_IMAGE_SIZE);
 
-    new_pixels = xreallocarray(NULL, new_width * new_height,
-            sizeof(*new_pixels));
+    prepare_cursor_scaler(scaler, image->header.width, image->header.height,
+            new_width, new_height);
 
-    /* very simple up/downscaling:
-     * if the new size is bigger, pixels are filled by copying the neighbor
-     * if the new size is smaller, pixels are skipped
-     */
-    for (uint32_t dest_y = 0; dest_y < new_height; dest_y++)
-    {
-        const uint32_t src_y = dest_y * image->size / new_size;
-        uint32_t *const src_row = image->pixels + src_y * image->header.width;
-        uint32_t *const dest_row = new_pixels + dest_y * new_width;
-        for (uint32_t dest_x = 0; dest_x < new_width; dest_x++)
-        {
-            const uint32_t src_x = dest_x * image->size / new_size;
-            dest_row[dest_x] = src_row[src_x];
-        }
-    }
-
-    image->header.width = new_width;
-    image->header.height = new_height;
-    image->header.xhot = image->header.xhot * new_size / image->size;
-    image->header.yhot = image->header.yhot * new_size / image->size;
-    image->size = new_size;
-    free(image->pixels);
-    image->pixels = new_pixels;
+    if (scaler->filter == XCURSOR_FILTER_BOX) {
+        scale_box(scaler, image);
+    } else {
+        scale_linear(scaler, image);
+    }
+
+    scaled->header.width = new_width;
+    scaled->header.height = new_height;
+    scaled->header.xhot = image->header.xhot * new_size / image->size;
+    scaled->header.yhot = image->header.yhot * new_size / image->size;
+    scaled->header.delay = image->header.delay;
+    scaled->size = new_size;
+    scaled->pixels = scaler->pixels;
+}
+
+/* Free the resources of @scaler. */
+static void clear_cursor_scaler(struct cursor_scaler *scaler)
+{
+    free(scaler->x_first);
+    free(scaler->x_second);
+    free(scaler->x_weight);
+    free(scaler->y_first);
+    free(scaler->y_second);
+    free(scaler->y_weight);
+    free(scaler->reciprocals);
+    free(scaler->pixels);
 }
 
 /* Create a cursor from an image loaded from an Xcursor file. */
@@ -568,13 +1044,14 @@ static xcb_cursor_t create_cursor_from_image(const struct xcursor_image *image)
 /* Load the cursor with given name using the user's preferred style. */
 xcb_cursor_t load_cursor(core_cursor_t cursor)
 {
-    FILE *file = NULL;
-    char *path;
+    const char *path = NULL;
 
     xcb_cursor_t cursor_id;
 
     struct xcursor_file xcursor;
     xcursor_error_t error;
+    struct cursor_scaler scaler;
+    struct xcursor_image scaled;
     uint32_t size = 0;
     uint32_t number_of_images = 0;
 
@@ -587,24 +1064,16 @@ xcb_cursor_t load_cursor(core_cursor_t cursor)
 
     /* if the core font is not preferred, load the preferred theme */
     if (xcursor_settings.has_create_cursor && !xcursor_settings.theme_core) {
-        /* load the font given by the user */
-        if (xcursor_settings.theme != NULL) {
-            file = open_cursor_file(xcursor_settings.theme, name, 0, &path);
-            if (file == NULL) {
-                LOG("could not find %s in %s\n", name, xcursor_settings.theme);
-            }
-        }
-
-        /* load the default font */
-        if (file == NULL) {
-            file = open_cursor_file("default", name, 0, &path);
-            if (file == NULL) {
-                LOG("could not find %s in %s\n", name, "default");
-            }
+        /* look in the theme given by the user and then the default theme */
+        path = find_cursor_file(name);
+        if (path == NULL) {
+            LOG("could not find %s in %s or default\n", name,
+                    xcursor_settings.theme == NULL ? "(none)" :
+                        xcursor_settings.theme);
         }
     }
 
-    if (file == NULL) {
+    if (path == NULL) {
         LOG("setting cursor %s using the core cursor font\n", name);
 
         if (xcursor_settings.cursor_font == XCB_NONE) {
@@ -627,37 +1096,21 @@ xcb_cursor_t load_cursor(core_cursor_t cursor)
 
     LOG("loading cursor %s from %s\n", name, path);
 
-    error = load_cursor_file(file, &xcursor);
-    if (error != XCURSOR_SUCCESS) {
-        const long file_position = ftell(file);
-        LOG_ERROR("error reading cursor file %s: %s "
-                    "(approximately at: %ld (%#lx))\n",
-                path, xcursor_error_strings[error],
-                file_position, file_position);
-        free(path);
-        fclose(file);
-        return XCB_NONE;
-    }
-    free(path);
-    fclose(file);
-
     /* if no size is given, use the dpi to make the cursor 16 "points" tall */
     const uint32_t target_size = xcursor_settings.size == 0 ?
         resources.dpi * 16 / 72 : xcursor_settings.size;
 
-    /* get the best fitting size and count all images that have this size */
-    for (uint32_t i = 0; i < xcursor.number_of_images; i++) {
-        const uint32_t image_size = xcursor.images[i].size;
-        if (size == 0 || ABSOLUTE_DIFFERENCE(image_size, target_size) <
-                ABSOLUTE_DIFFERENCE(size, target_size)) {
-            size = image_size;
-            number_of_images = 0;
-        }
-        if (image_size == size) {
-            number_of_images++;
-        }
+    /* load the images with the best fitting size */
+    error = load_cursor_file(path, target_size, &xcursor);
+    if (error != XCURSOR_SUCCESS) {
+        LOG_ERROR("error reading cursor file %s: %s\n",
+                path, xcursor_error_strings[error]);
+        return XCB_NONE;
     }
 
+    size = xcursor.images[0].size;
+    number_of_images = xcursor.number_of_images;
+
     LOG("cursor consists of %u equally sized images\n", number_of_images);
 
     if (!xcursor_settings.animated && number_of_images > 1) {
@@ -668,29 +1121,37 @@ xcb_cursor_t load_cursor(core_cursor_t cursor)
 
     if (target_size != size && xcursor_settings.resized) {
         LOG("artificial sizing will be done to get from size %" PRIu32 " to %"
-                    PRIu32 "\n",
-                size, target_size);
+                    PRIu32 " using the %s filter\n",
+                size, target_size,
+                xcursor_filter_strings[xcursor_settings.filter]);
     }
 
     /* create an animated cursor or not if it is just a single image */
     xcb_render_animcursorelt_t cursors[number_of_images];
 
-    for (uint32_t i = 0, j = 0; j < number_of_images; i++) {
-        struct xcursor_image *const image = &xcursor.images[i];
-        if (image->size != size) {
-            continue;
-        }
+    /* all images of a cursor have the same size so they share the scaler */
+    memset(&scaler, 0, sizeof(scaler));
+    scaler.filter = xcursor_settings.filter;
+    if (scaler.filter == XCURSOR_FILTER_SMOOTH) {
+        scaler.filter = target_size < size ? XCURSOR_FILTER_BOX :
+            XCURSOR_FILTER_BILINEAR;
+    }
+
+    for (uint32_t i = 0; i < number_of_images; i++) {
+        const struct xcursor_image *image = &xcursor.images[i];
 
         /* scale the image if needed and wanted */
         if (image->size != target_size && xcursor_settings.resized) {
-            scale_cursor_image(image, target_size);
+            scale_cursor_image(&scaler, image, target_size, &scaled);
+            image = &scaled;
         }
 
-        cursors[j].cursor = create_cursor_from_image(image);
-        cursors[j].delay = image->header.delay;
-        j++;
+        cursors[i].cursor = create_cursor_from_image(image);
+        cursors[i].delay = image->header.delay;
     }
 
+    clear_cursor_scaler(&scaler);
+
     if (number_of_images > 1) {
         cursor_id = xcb_generate_id(connection);
         xcb_render_create_anim_cursor(connection, cursor_id,
@@ -718,4 +1179,7 @@ void clear_cursor_cache(void)
             cached_cursors[i] = XCB_NONE;
         }
     }
+
+    /* the theme or cursor path might have changed */
+    clear_cursor_theme_index();
 }
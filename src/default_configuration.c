@@ -34,6 +34,7 @@ const struct configuration default_configuration = {
     .font = {
         .use_core_font = false,
         .name = (utf8_t*) "Mono",
+        .cache_glyphs = false,
     },
 
     .border = {
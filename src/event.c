@@ -10,10 +10,13 @@
 #include "event.h"
 #include "fensterchef.h"
 #include "frame.h"
+#include "ipc.h"
 #include "keymap.h"
+#include "latency.h"
 #include "log.h"
 #include "monitor.h"
 #include "tiling.h"
+#include "trace.h"
 #include "resources.h"
 #include "size_frame.h"
 #include "utility.h"
@@ -37,6 +40,9 @@ uint8_t randr_event_base;
 /* signals whether the alarm signal was received */
 volatile sig_atomic_t has_timer_expired;
 
+/* signals whether the user signal requesting the latencies was received */
+static volatile sig_atomic_t is_latency_dump_requested;
+
 /* if the user requested to reload the configuration */
 bool is_reload_requested;
 
@@ -55,8 +61,22 @@ static struct {
     Rectangle initial_geometry;
     /* the initial position of the mouse */
     Point start;
+    /* Motion events are compressed: only the last position received within a
+     * batch of events is applied.
+     */
+    /* if there is a mouse position that was not applied yet */
+    bool has_pending_motion;
+    /* the last received mouse position */
+    Point pending;
+    /* the number of motion events received during this move/resize */
+    uint32_t received_motions;
+    /* the number of motion events actually applied */
+    uint32_t applied_motions;
 } move_resize;
 
+/* Move/resize the window according to the last received mouse position. */
+static void apply_pending_motion(void);
+
 /* Handle an incoming alarm. */
 static void alarm_handler(int signal)
 {
@@ -64,7 +84,14 @@ static void alarm_handler(int signal)
     has_timer_expired = true;
 }
 
-/* Create a signal handler for `SIGALRM`. */
+/* Handle an incoming request for the latencies. */
+static void latency_dump_handler(int signal)
+{
+    (void) signal;
+    is_latency_dump_requested = true;
+}
+
+/* Create a signal handler for `SIGALRM` and `SIGUSR1`. */
 int initialize_signal_handlers(void)
 {
     struct sigaction action;
@@ -79,13 +106,76 @@ int initialize_signal_handlers(void)
         LOG_ERROR("could not create alarm handler\n");
         return ERROR;
     }
+
+    /* the user signal writes the latency histograms to the log */
+    action.sa_handler = latency_dump_handler;
+    if (sigaction(SIGUSR1, &action, NULL) == -1) {
+        LOG_ERROR("could not create latency dump handler\n");
+        return ERROR;
+    }
     return OK;
 }
 
+/* a list of window ids that mirrors a client list property on the root */
+struct client_list {
+    /* the ids of the windows as last sent to the X server */
+    xcb_window_t *ids;
+    /* the number of ids */
+    uint32_t length;
+    /* the number of allocated ids */
+    uint32_t capacity;
+    /* if the property was set at least once by us */
+    bool is_initialized;
+};
+
+/* Update the root @property so that it contains the @length ids in
+ * @new_ids.
+ *
+ * When the previously sent list is a prefix of the new list, only the new ids
+ * are appended, otherwise the property is replaced entirely.
+ */
+static void update_client_list(struct client_list *list, xcb_atom_t property,
+        const xcb_window_t *new_ids, uint32_t length)
+{
+    uint32_t common = 0;
+
+    if (list->is_initialized) {
+        const uint32_t minimum = MIN(list->length, length);
+        while (common < minimum && list->ids[common] == new_ids[common]) {
+            common++;
+        }
+    }
+
+    if (list->is_initialized && common == list->length) {
+        /* pure addition (or nothing changed at all) */
+        if (length > common) {
+            xcb_change_property(connection, XCB_PROP_MODE_APPEND,
+                    screen->root, property, XCB_ATOM_WINDOW, 32,
+                    length - common, &new_ids[common]);
+        }
+    } else {
+        xcb_change_property(connection, XCB_PROP_MODE_REPLACE,
+                screen->root, property, XCB_ATOM_WINDOW, 32,
+                length, new_ids);
+        list->is_initialized = true;
+    }
+
+    /* remember what the server has now */
+    if (length > list->capacity) {
+        list->capacity = length;
+        RESIZE(list->ids, list->capacity);
+    }
+    memcpy(&list->ids[common], &new_ids[common],
+            sizeof(*new_ids) * (length - common));
+    list->length = length;
+}
+
 /* Set the client list root property. */
 void synchronize_client_list(void)
 {
-    /* a list of window ids that is synchronized with the actual windows */
+    /* the client lists last sent to the server */
+    static struct client_list age_list, stacking_list;
+    /* a buffer to build the new lists in */
     static struct {
         /* the id of the window */
         xcb_window_t *ids;
@@ -93,9 +183,12 @@ void synchronize_client_list(void)
         uint32_t length;
     } client_list;
 
+    uint64_t start;
     Window *window;
     uint32_t index = 0;
 
+    start = get_monotonic_time();
+
     if (Window_count > client_list.length) {
         client_list.length = Window_count;
         RESIZE(client_list.ids, client_list.length);
@@ -106,10 +199,11 @@ void synchronize_client_list(void)
         client_list.ids[index] = window->client.id;
         index++;
     }
-    /* set the `_NET_CLIENT_LIST` property */
-    xcb_change_property(connection, XCB_PROP_MODE_REPLACE, screen->root,
-            ATOM(_NET_CLIENT_LIST), XCB_ATOM_WINDOW, 32,
-            Window_count, client_list.ids);
+    /* set the `_NET_CLIENT_LIST` property, new windows are always the newest
+     * so this is usually only an append
+     */
+    update_client_list(&age_list, ATOM(_NET_CLIENT_LIST),
+            client_list.ids, Window_count);
 
     index = 0;
     /* sort the list in order of the Z stacking (bottom to top) */
@@ -118,60 +212,186 @@ void synchronize_client_list(void)
         index++;
     }
     /* set the `_NET_CLIENT_LIST_STACKING` property */
-    xcb_change_property(connection, XCB_PROP_MODE_REPLACE, screen->root,
-            ATOM(_NET_CLIENT_LIST_STACKING), XCB_ATOM_WINDOW, 32,
-            Window_count, client_list.ids);
+    update_client_list(&stacking_list, ATOM(_NET_CLIENT_LIST_STACKING),
+            client_list.ids, Window_count);
+
+    record_latency(LATENCY_SYNCHRONIZE_CLIENT_LIST, start);
 }
 
-/* Recursively check if the window is contained within @frame. */
+/* Check if @window is contained within @frame or any of its children. */
 static bool is_window_part_of(Window *window, Frame *frame)
+{
+    Frame *window_frame;
+
+    window_frame = get_frame_of_window(window);
+    for (; window_frame != NULL; window_frame = window_frame->parent) {
+        if (window_frame == frame) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Mark all windows within @frame and its children as dirty. */
+static void mark_frame_windows_dirty(Frame *frame)
 {
     if (frame->left != NULL) {
-        return is_window_part_of(window, frame->left) ||
-            is_window_part_of(window, frame->right);
+        mark_frame_windows_dirty(frame->left);
+        mark_frame_windows_dirty(frame->right);
+    } else if (frame->window != NULL) {
+        mark_window_dirty(frame->window);
+    }
+}
+
+/* Replace the pointer in @reference with @window and move the reference
+ * counting along.
+ */
+static void exchange_window_reference(Window **reference, Window *window)
+{
+    if (*reference == window) {
+        return;
+    }
+    if (window != NULL) {
+        reference_window(window);
+    }
+    if (*reference != NULL) {
+        dereference_window(*reference);
+    }
+    *reference = window;
+}
+
+/* Mark all windows whose border color depends on what changed about the focus
+ * or top window since the last synchronization.
+ */
+static void mark_focus_changes_dirty(void)
+{
+    /* the state at the time of the last synchronization */
+    static struct {
+        /* the focused window */
+        Window *focus;
+        /* the mode of the focused window */
+        window_mode_t focus_mode;
+        /* the focused frame */
+        Frame *frame;
+        /* the window at the top of the Z stack */
+        Window *top;
+    } last;
+
+    const window_mode_t focus_mode = Window_focus == NULL ? WINDOW_MODE_MAX :
+        Window_focus->state.mode;
+
+    if (last.focus == Window_focus && last.focus_mode == focus_mode &&
+            last.frame == Frame_focus && last.top == Window_top) {
+        return;
+    }
+
+    /* windows that got destroyed are filtered out when synchronizing */
+    if (last.focus != NULL) {
+        mark_window_dirty(last.focus);
+    }
+    if (last.top != NULL) {
+        mark_window_dirty(last.top);
+    }
+    if (Window_focus != NULL) {
+        mark_window_dirty(Window_focus);
+    }
+    if (Window_top != NULL) {
+        mark_window_dirty(Window_top);
+    }
+
+    /* the windows within the old and new focused frame */
+    if (last.frame != NULL) {
+        mark_frame_windows_dirty(last.frame);
+    }
+    if (Frame_focus != NULL) {
+        mark_frame_windows_dirty(Frame_focus);
+    }
+
+    exchange_window_reference(&last.focus, Window_focus);
+    exchange_window_reference(&last.top, Window_top);
+    last.focus_mode = focus_mode;
+    if (last.frame != Frame_focus) {
+        if (Frame_focus != NULL) {
+            reference_frame(Frame_focus);
+        }
+        if (last.frame != NULL) {
+            dereference_frame(last.frame);
+        }
+        last.frame = Frame_focus;
+    }
+}
+
+/* Get the border color @window should have. */
+static uint32_t get_window_border_color(Window *window)
+{
+    /* set the color of the focused window */
+    if (window == Window_focus) {
+        return configuration.border.focus_color;
+    }
+    /* deeply set the colors of all windows within the focused frame */
+    if ((Window_focus == NULL ||
+                Window_focus->state.mode == WINDOW_MODE_TILING) &&
+            window->state.mode == WINDOW_MODE_TILING &&
+            is_window_part_of(window, Frame_focus)) {
+        return configuration.border.focus_color;
     }
-    return frame->window == window;
+    /* if the window is the top window or within the focused frame, give it
+     * the active color
+     */
+    if (is_window_part_of(window, Frame_focus) ||
+            (window->state.mode == WINDOW_MODE_FLOATING &&
+             window == Window_top)) {
+        return configuration.border.active_color;
+    }
+    return configuration.border.color;
 }
 
-/* Synchronize the local data with the X server. */
+/* Synchronize the local data with the X server.
+ *
+ * Only the windows within the dirty linked list are synchronized.
+ */
 void synchronize_with_server(void)
 {
+    uint64_t start;
+    Window *window, *dirty;
     xcb_atom_t state_atom;
 
+    start = get_monotonic_time();
+
     /* since the strut of a monitor might have changed because a window with
      * strut got hidden or shown, we need to recompute those
      */
-    reconfigure_monitor_frames();
+    if (are_monitors_dirty) {
+        reconfigure_monitor_frames();
+        /* the dock windows changing their size while reconfiguring marks the
+         * monitors as dirty again
+         */
+        are_monitors_dirty = false;
+    }
+
+    mark_focus_changes_dirty();
+
+    /* take the dirty list, no new windows are marked as dirty from here on */
+    dirty = Window_first_dirty;
+    Window_first_dirty = NULL;
+    for (window = dirty; window != NULL; window = window->next_dirty) {
+        window->is_dirty = false;
+    }
+
+    /* configure all visible windows and map them */
+    for (window = dirty; window != NULL; window = window->next_dirty) {
+        /* skip destroyed windows */
+        if (window->client.id == XCB_NONE) {
+            continue;
+        }
 
-    /* set the border colors of the windows */
-    for (Window *window = Window_first; window != NULL; window = window->next) {
         if (window != Window_focus) {
             state_atom = ATOM(_NET_WM_STATE_FOCUSED);
             remove_window_states(window, &state_atom, 1);
         }
-        /* set the color of the focused window */
-        if (window == Window_focus) {
-            window->border_color = configuration.border.focus_color;
-        /* deeply set the colors of all windows within the focused frame */
-        } else if ((Window_focus == NULL ||
-                    Window_focus->state.mode == WINDOW_MODE_TILING) &&
-                window->state.mode == WINDOW_MODE_TILING &&
-                is_window_part_of(window, Frame_focus)) {
-            window->border_color = configuration.border.focus_color;
-        /* if the window is the top window or within the focused frame, give it
-         * the active color
-         */
-        } else if (is_window_part_of(window, Frame_focus) ||
-                (window->state.mode == WINDOW_MODE_FLOATING &&
-                 window == Window_top)) {
-            window->border_color = configuration.border.active_color;
-        } else {
-            window->border_color = configuration.border.color;
-        }
-    }
 
-    /* configure all visible windows and map them */
-    for (Window *window = Window_top; window != NULL; window = window->below) {
+        window->border_color = get_window_border_color(window);
+
         if (!window->state.is_visible) {
             continue;
         }
@@ -184,15 +404,22 @@ void synchronize_with_server(void)
         map_client(&window->client);
     }
 
-    /* unmap all invisible windows */
-    for (Window *window = Window_bottom; window != NULL;
-            window = window->above) {
-        if (!window->state.is_visible) {
+    /* unmap all invisible windows and drop the references */
+    while (dirty != NULL) {
+        window = dirty;
+        dirty = dirty->next_dirty;
+
+        if (window->client.id != XCB_NONE && !window->state.is_visible) {
             state_atom = ATOM(_NET_WM_STATE_HIDDEN);
             add_window_states(window, &state_atom, 1);
             unmap_client(&window->client);
         }
+
+        window->next_dirty = NULL;
+        dereference_window(window);
     }
+
+    record_latency(LATENCY_SYNCHRONIZE_WITH_SERVER, start);
 }
 
 /* Run the next cycle of the event loop. */
@@ -202,7 +429,10 @@ int next_cycle(void)
     Window *old_focus_window;
     Frame *old_focus_frame;
     xcb_generic_event_t *event;
-    fd_set set;
+    fd_set read_set;
+    fd_set write_set;
+    int maximum_descriptor;
+    uint64_t start;
 
     connection_error = xcb_connection_has_error(connection);
     if (!Fensterchef_is_running || connection_error > 0) {
@@ -223,17 +453,39 @@ int next_cycle(void)
         reference_frame(old_focus_frame);
     }
 
-    /* prepare `set` for `select()` */
-    FD_ZERO(&set);
-    FD_SET(x_file_descriptor, &set);
+    /* prepare the sets for `select()` */
+    FD_ZERO(&read_set);
+    FD_ZERO(&write_set);
+    FD_SET(x_file_descriptor, &read_set);
+    maximum_descriptor = MAX(x_file_descriptor,
+            set_ipc_file_descriptors(&read_set, &write_set));
 
     /* using select here is key: select will block until data on the file
-     * descriptor for the X connection arrives; when a signal is received,
-     * `select()` will however also unblock and return -1
+     * descriptor for the X connection or any client of the socket arrives;
+     * when a signal is received, `select()` will however also unblock and
+     * return -1
      */
-    if (select(x_file_descriptor + 1, &set, NULL, NULL, NULL) > 0) {
+    if (select(maximum_descriptor + 1, &read_set, &write_set, NULL,
+                NULL) > 0) {
+        /* run the commands external programs sent; this comes before handling
+         * the events because the round trips of commands queue up events
+         * without making the X connection readable for `select()`
+         */
+        handle_ipc_file_descriptors(&read_set, &write_set);
+        if (is_reload_requested) {
+            reload_user_configuration();
+            is_reload_requested = false;
+        }
+
         /* handle all received events */
         while (event = xcb_poll_for_event(connection), event != NULL) {
+            /* any event other than a motion event might change the state, so
+             * apply the compressed motion beforehand
+             */
+            if ((event->response_type & ~0x80) != XCB_MOTION_NOTIFY) {
+                apply_pending_motion();
+            }
+
             handle_window_list_event(event);
 
             handle_event(event);
@@ -246,6 +498,8 @@ int next_cycle(void)
             free(event);
         }
 
+        apply_pending_motion();
+
         synchronize_with_server();
         /* update the client list properties */
         if (has_client_list_changed) {
@@ -255,6 +509,8 @@ int next_cycle(void)
 
         if (old_focus_window != Window_focus) {
             set_input_focus(Window_focus);
+            publish_ipc_event(IPC_EVENT_FOCUS, "%#" PRIx32,
+                    Window_focus == NULL ? XCB_NONE : Window_focus->client.id);
         }
 
         if (old_focus_frame != Frame_focus ||
@@ -276,6 +532,10 @@ int next_cycle(void)
                         Frame_focus->y + Frame_focus->height / 2);
             }
             LOG("frame %F was focused\n", Frame_focus);
+            publish_ipc_event(IPC_EVENT_FRAME_FOCUS,
+                    "%" PRIu32 " %" PRId32 " %" PRId32 " %" PRIu32 " %" PRIu32,
+                    Frame_focus->number, Frame_focus->x, Frame_focus->y,
+                    Frame_focus->width, Frame_focus->height);
         }
     }
 
@@ -284,6 +544,11 @@ int next_cycle(void)
         has_timer_expired = false;
     }
 
+    if (is_latency_dump_requested) {
+        dump_latencies(stderr);
+        is_latency_dump_requested = false;
+    }
+
     /* no longer need them */
     if (old_focus_frame != NULL) {
         dereference_frame(old_focus_frame);
@@ -292,8 +557,13 @@ int next_cycle(void)
         dereference_window(old_focus_window);
     }
 
+    /* send the event lines to the subscribed clients */
+    flush_ipc_events();
+
     /* flush after every series of events so all changes are reflected */
+    start = get_monotonic_time();
     xcb_flush(connection);
+    record_latency(LATENCY_FLUSH, start);
 
     return OK;
 }
@@ -326,7 +596,8 @@ void initiate_window_move_resize(Window *window,
     /* get the mouse position if the caller does not supply it */
     if (start_x < 0) {
         query_cookie = xcb_query_pointer(connection, screen->root);
-        query = xcb_query_pointer_reply(connection, query_cookie, &error);
+        query = ROUND_TRIP(xcb_query_pointer_reply(connection, query_cookie,
+                    &error));
         if (query == NULL) {
             LOG_ERROR("could not query pointer: %E\n", error);
             free(error);
@@ -382,6 +653,9 @@ void initiate_window_move_resize(Window *window,
     move_resize.initial_geometry.height = window->height;
     move_resize.start.x = start_x;
     move_resize.start.y = start_y;
+    move_resize.has_pending_motion = false;
+    move_resize.received_motions = 0;
+    move_resize.applied_motions = 0;
 
     /* determine a fitting cursor */
     switch (direction) {
@@ -410,7 +684,7 @@ void initiate_window_move_resize(Window *window,
                 XCB_EVENT_MASK_BUTTON_MOTION,
             XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC, screen->root,
             xcb_cursor, XCB_CURRENT_TIME);
-    grab = xcb_grab_pointer_reply(connection, grab_cookie, &error);
+    grab = ROUND_TRIP(xcb_grab_pointer_reply(connection, grab_cookie, &error));
     if (grab == NULL) {
         LOG_ERROR("could not grab pointer: %E\n", error);
         free(error);
@@ -436,7 +710,9 @@ static void cancel_window_move_resize(void)
         return;
     }
 
-    LOG("cancelling move/resize for %W\n", move_resize.window);
+    LOG("cancelling move/resize for %W, applied %" PRIu32 " of %" PRIu32
+            " motion events\n", move_resize.window,
+            move_resize.applied_motions, move_resize.received_motions);
 
     /* restore the old position and size as good as we can */
     frame = get_frame_of_window(move_resize.window);
@@ -552,6 +828,9 @@ static void handle_button_release(xcb_button_release_event_t *event)
     struct configuration_button *button;
 
     if (move_resize.window != NULL) {
+        LOG("finished move/resize for %W, applied %" PRIu32 " of %" PRIu32
+                " motion events\n", move_resize.window,
+                move_resize.applied_motions, move_resize.received_motions);
         /* release mouse events back to the applications */
         xcb_ungrab_pointer(connection, XCB_CURRENT_TIME);
         move_resize.window = NULL;
@@ -578,10 +857,8 @@ static void handle_button_release(xcb_button_release_event_t *event)
     }
 }
 
-/* Motion notifications (mouse move events) are only sent when we grabbed them.
- * This only happens when a floating window is being moved.
- */
-static void handle_motion_notify(xcb_motion_notify_event_t *event)
+/* Move/resize the window according to the last received mouse position. */
+static void apply_pending_motion(void)
 {
     Rectangle new_geometry;
     Size minimum, maximum;
@@ -589,18 +866,24 @@ static void handle_motion_notify(xcb_motion_notify_event_t *event)
     int32_t left_delta, top_delta, right_delta, bottom_delta;
     Frame *frame;
 
+    if (!move_resize.has_pending_motion) {
+        return;
+    }
+    move_resize.has_pending_motion = false;
+
     if (move_resize.window == NULL) {
-        LOG_ERROR("receiving motion events without a window to move?\n");
         return;
     }
 
+    move_resize.applied_motions++;
+
     new_geometry = move_resize.initial_geometry;
 
     get_minimum_window_size(move_resize.window, &minimum);
     get_maximum_window_size(move_resize.window, &maximum);
 
-    delta_x = move_resize.start.x - event->root_x;
-    delta_y = move_resize.start.y - event->root_y;
+    delta_x = move_resize.start.x - move_resize.pending.x;
+    delta_y = move_resize.start.y - move_resize.pending.y;
 
     /* prevent overflows and clip so that moving an edge when no more size is
      * available does not move the window
@@ -718,6 +1001,25 @@ static void handle_motion_notify(xcb_motion_notify_event_t *event)
     }
 }
 
+/* Motion notifications (mouse move events) are only sent when we grabbed them.
+ * This only happens when a floating window is being moved.
+ *
+ * The motion is not applied immediately but only after all events that are
+ * currently queued up were handled, see `apply_pending_motion()`.
+ */
+static void handle_motion_notify(xcb_motion_notify_event_t *event)
+{
+    if (move_resize.window == NULL) {
+        LOG_ERROR("receiving motion events without a window to move?\n");
+        return;
+    }
+
+    move_resize.has_pending_motion = true;
+    move_resize.pending.x = event->root_x;
+    move_resize.pending.y = event->root_y;
+    move_resize.received_motions++;
+}
+
 /* Unmap notifications are sent after a window decided it wanted to not be seen
  * anymore.
  */
@@ -962,11 +1264,11 @@ static void handle_screen_change(xcb_randr_screen_change_notify_event_t *event)
     merge_monitors(query_monitors());
 }
 
-/* Handle the given xcb event.
+/* Pass the given xcb event to its handler.
  *
  * Descriptions for each event are above each handler.
  */
-void handle_event(xcb_generic_event_t *event)
+static void dispatch_event(xcb_generic_event_t *event)
 {
     uint8_t type;
 
@@ -1065,5 +1367,23 @@ void handle_event(xcb_generic_event_t *event)
     case XCB_MAPPING_NOTIFY:
         handle_mapping_notify((xcb_mapping_notify_event_t*) event);
         break;
+
+    /* a region of the notification window needs to be shown again */
+    case XCB_EXPOSE:
+        handle_notification_expose((xcb_expose_event_t*) event);
+        break;
     }
 }
+
+/* Handle the given xcb event. */
+void handle_event(xcb_generic_event_t *event)
+{
+    uint64_t start;
+
+    start = get_monotonic_time();
+
+    dispatch_event(event);
+
+    record_latency(event->response_type & ~0x80, start);
+    trace_event(event, start);
+}
@@ -1,9 +1,13 @@
 #include <unistd.h> // alarm()
 
+#include "action.h"
 #include "configuration.h"
 #include "fensterchef.h"
+#include "ipc.h"
 #include "log.h"
 #include "render.h"
+#include "trace.h"
+#include "window.h"
 #include "x11_management.h"
 
 /* the home directory */
@@ -15,7 +19,10 @@ bool Fensterchef_is_running;
 /* the path of the configuration file */
 char *Fensterchef_configuration;
 
-/* Spawn a window that has the `FENSTERCHEF_COMMAND` property. */
+/* the off-screen buffer the notification is drawn onto */
+static BackBuffer notification_buffer;
+
+/* Send @command to the running fensterchef instance. */
 void run_external_command(const char *command)
 {
     xcb_connection_t *connection;
@@ -33,6 +40,11 @@ void run_external_command(const char *command)
     xcb_window_t window;
     xcb_generic_event_t *event;
 
+    /* try the fast way through the socket first */
+    if (send_ipc_command(command) == OK) {
+        return;
+    }
+
     connection = xcb_connect(NULL, &screen_number);
     connection_error = xcb_connection_has_error(connection);
     if (connection_error > 0) {
@@ -111,16 +123,55 @@ void run_external_command(const char *command)
     xcb_disconnect(connection);
 }
 
+/* Parse @command as list of actions and run them. */
+bool run_command(const char *command)
+{
+    struct configuration configuration;
+    bool result = false;
+
+    if (load_configuration(command, &configuration, false) != OK) {
+        return false;
+    }
+
+    LOG("doing actions: %A\n",
+            configuration.startup.number_of_actions,
+            configuration.startup.actions);
+    for (uint32_t i = 0; i < configuration.startup.number_of_actions; i++) {
+        result = do_action(&configuration.startup.actions[i], Window_focus);
+    }
+    clear_configuration(&configuration);
+    return result;
+}
+
 /* Close the connection to the X server and exit the program with given exit
  * code.
  */
 void quit_fensterchef(int exit_code)
 {
     LOG("quitting fensterchef with exit code: %d\n", exit_code);
+    deinitialize_ipc();
+    deinitialize_trace();
     xcb_disconnect(connection);
+    deinitialize_logging();
     exit(exit_code);
 }
 
+/* Copy the exposed region of the notification window from its back buffer. */
+void handle_notification_expose(xcb_expose_event_t *event)
+{
+    xcb_rectangle_t rectangle;
+
+    if (event->window != notification.id) {
+        return;
+    }
+
+    rectangle.x = event->x;
+    rectangle.y = event->y;
+    rectangle.width = event->width;
+    rectangle.height = event->height;
+    present_back_buffer(&notification_buffer, &rectangle);
+}
+
 /* Show the notification window with given message at given coordinates. */
 void set_notification(const utf8_t *message, int32_t x, int32_t y)
 {
@@ -157,17 +208,23 @@ void set_notification(const utf8_t *message, int32_t x, int32_t y)
     /* show the window */
     map_client(&notification);
 
-    /* render the notification on the window */
+    /* render the notification off-screen and then copy it onto the window */
     rectangle.x = 0;
     rectangle.y = 0;
     rectangle.width = measure.total_width;
     rectangle.height = measure.ascent - measure.descent +
         configuration.notification.padding;
-    draw_text(notification.id, message, message_length,
+    notification_buffer.window = notification.id;
+    (void) resize_back_buffer(&notification_buffer, rectangle.width,
+            rectangle.height);
+    fill_back_buffer(&notification_buffer, &rectangle,
+            configuration.notification.background);
+    draw_text(notification_buffer.pixmap, message, message_length,
             configuration.notification.background,
-            &rectangle, configuration.notification.foreground,
+            NULL, configuration.notification.foreground,
             configuration.notification.padding / 2,
             measure.ascent + configuration.notification.padding / 2);
+    present_back_buffer(&notification_buffer, &rectangle);
 
     /* set an alarm to trigger after @configuration.notification.duration */
     alarm(configuration.notification.duration);
@@ -60,6 +60,11 @@ void destroy_frame(Frame *frame)
                 "this might leak memory\n");
     }
 
+    /* do not leave a dangling frame pointer within the window */
+    if (frame->window != NULL) {
+        set_frame_window(frame, NULL);
+    }
+
     /* we could also check for a case where the frame is the root frame of a
      * monitor but checking too much is not good; these things should not happen
      * anyway
@@ -185,17 +190,17 @@ void replace_frame(Frame *frame, Frame *with)
         /* one null set for convenience, otherwise the very natural looking
          * swapping in `exchange_frames()` would not work
          */
-        frame->window = NULL;
+        set_frame_window(frame, NULL);
 
         with->left = NULL;
         with->right = NULL;
     } else {
-        frame->window = with->window;
+        set_frame_window(frame, with->window);
         /* two null sets for convenience */
         frame->left = NULL;
         frame->right = NULL;
 
-        with->window = NULL;
+        set_frame_window(with, NULL);
     }
 
     /* size the children so they fit into their new parent */
@@ -203,6 +208,22 @@ void replace_frame(Frame *frame, Frame *with)
             frame->width, frame->height);
 }
 
+/* Set the window inside @frame to @window. */
+void set_frame_window(Frame *frame, Window *window)
+{
+    /* only unlink the old window if it was not moved to another frame already
+     */
+    if (frame->window != NULL && frame->window->frame == frame) {
+        frame->window->frame = NULL;
+    }
+
+    frame->window = window;
+
+    if (window != NULL) {
+        window->frame = frame;
+    }
+}
+
 /* Get the gaps the frame applies to its inner window. */
 void get_frame_gaps(const Frame *frame, Extents *gaps)
 {
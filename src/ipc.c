@@ -0,0 +1,705 @@
+/* for `struct ucred` */
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "fensterchef.h"
+#include "ipc.h"
+#include "log.h"
+#include "utility.h"
+
+/* a client connected to our socket */
+struct ipc_connection {
+    /* the file descriptor of the connection */
+    int fd;
+    /* the received data that does not form a complete command yet */
+    char input[IPC_MAXIMUM_COMMAND_LENGTH];
+    /* the number of bytes within `input` */
+    size_t input_length;
+    /* the data that still needs to be sent */
+    char *output;
+    /* the number of bytes within `output` */
+    size_t output_length;
+    /* bit mask of the events (`1 << event`) the client subscribed to */
+    uint32_t subscriptions;
+    /* the number of event lines dropped because the client was not reading */
+    uint32_t dropped_events;
+    /* if the client closed its side, the connection is closed once all output
+     * is sent
+     */
+    bool is_input_closed;
+};
+
+/* the names of all events */
+static const char *ipc_event_names[IPC_EVENT_MAX] = {
+#define X(event, name) [event] = name,
+    DEFINE_ALL_IPC_EVENTS
+#undef X
+};
+
+/* the socket server */
+static struct ipc {
+    /* the file descriptor of the listening socket, -1 if there is none */
+    int fd;
+    /* the path of the socket */
+    char path[sizeof(((struct sockaddr_un*) NULL)->sun_path)];
+    /* all connected clients */
+    struct ipc_connection connections[IPC_MAXIMUM_CONNECTIONS];
+    /* the number of connected clients */
+    uint32_t number_of_connections;
+    /* if a command of a client is running */
+    bool is_running_command;
+    /* the output of the running command or `NULL` if there is none yet */
+    FILE *command_output;
+    /* the memory of `command_output` */
+    char *command_output_data;
+    /* the size of `command_output_data` */
+    size_t command_output_size;
+} ipc = {
+    .fd = -1,
+};
+
+/* Put the path of the socket into @address.
+ *
+ * @return ERROR if the path is too long.
+ */
+static int get_socket_path(struct sockaddr_un *address)
+{
+    const char *display;
+    const char *runtime_directory;
+    size_t prefix_length;
+    int length;
+
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+
+    display = getenv("DISPLAY");
+    if (display == NULL) {
+        display = "";
+    }
+
+    runtime_directory = getenv("XDG_RUNTIME_DIR");
+    if (runtime_directory != NULL && runtime_directory[0] != '\0') {
+        length = snprintf(address->sun_path, sizeof(address->sun_path),
+                "%s/fensterchef-", runtime_directory);
+    } else {
+        length = snprintf(address->sun_path, sizeof(address->sun_path),
+                "/tmp/fensterchef-%u-", (unsigned) getuid());
+    }
+    if (length < 0 || (size_t) length >= sizeof(address->sun_path)) {
+        return ERROR;
+    }
+    prefix_length = length;
+
+    length = snprintf(&address->sun_path[prefix_length],
+            sizeof(address->sun_path) - prefix_length, "%s", display);
+    if ((size_t) length >= sizeof(address->sun_path) - prefix_length) {
+        return ERROR;
+    }
+
+    /* the display may contain slashes, they must not create directories */
+    for (size_t i = prefix_length; address->sun_path[i] != '\0'; i++) {
+        if (address->sun_path[i] == '/') {
+            address->sun_path[i] = '_';
+        }
+    }
+    return OK;
+}
+
+/* Make @fd non blocking and not inherited by child processes. */
+static int set_descriptor_flags(int fd)
+{
+    int flags;
+
+    flags = fcntl(fd, F_GETFL);
+    if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1) {
+        return ERROR;
+    }
+    if (fcntl(fd, F_SETFD, FD_CLOEXEC) == -1) {
+        return ERROR;
+    }
+    return OK;
+}
+
+/* Create the socket external programs can connect to. */
+int initialize_ipc(void)
+{
+    struct sockaddr_un address;
+    int fd;
+    mode_t old_mask;
+    int result;
+
+    if (get_socket_path(&address) != OK) {
+        LOG_ERROR("the socket path is too long\n");
+        return ERROR;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        LOG_ERROR("could not create socket: %s\n", strerror(errno));
+        return ERROR;
+    }
+
+    if (set_descriptor_flags(fd) != OK) {
+        LOG_ERROR("could not configure socket: %s\n", strerror(errno));
+        close(fd);
+        return ERROR;
+    }
+
+    /* we are the only window manager on this display, so any existing socket
+     * is a left over from an earlier instance
+     */
+    unlink(address.sun_path);
+
+    /* only the user running fensterchef may connect to the socket */
+    old_mask = umask(S_IRWXG | S_IRWXO);
+    result = bind(fd, (struct sockaddr*) &address, sizeof(address));
+    umask(old_mask);
+    if (result == -1) {
+        LOG_ERROR("could not bind socket to %s: %s\n", address.sun_path,
+                strerror(errno));
+        close(fd);
+        return ERROR;
+    }
+
+    if (listen(fd, IPC_MAXIMUM_CONNECTIONS) == -1) {
+        LOG_ERROR("could not listen on socket %s: %s\n", address.sun_path,
+                strerror(errno));
+        close(fd);
+        unlink(address.sun_path);
+        return ERROR;
+    }
+
+    ipc.fd = fd;
+    strcpy(ipc.path, address.sun_path);
+
+    LOG("listening for commands on %s\n", ipc.path);
+    return OK;
+}
+
+/* Close the connection at @index and remove it from the connection list. */
+static void close_connection(uint32_t index)
+{
+    struct ipc_connection *const connection = &ipc.connections[index];
+
+    close(connection->fd);
+    free(connection->output);
+
+    ipc.number_of_connections--;
+    if (index != ipc.number_of_connections) {
+        *connection = ipc.connections[ipc.number_of_connections];
+    }
+}
+
+/* Close all connections and remove the socket. */
+void deinitialize_ipc(void)
+{
+    if (ipc.fd == -1) {
+        return;
+    }
+
+    while (ipc.number_of_connections > 0) {
+        close_connection(ipc.number_of_connections - 1);
+    }
+
+    close(ipc.fd);
+    ipc.fd = -1;
+    unlink(ipc.path);
+}
+
+/* Add the file descriptors of the socket and all connections to @read_set and
+ * @write_set.
+ */
+int set_ipc_file_descriptors(fd_set *read_set, fd_set *write_set)
+{
+    int maximum;
+
+    if (ipc.fd == -1) {
+        return -1;
+    }
+
+    FD_SET(ipc.fd, read_set);
+    maximum = ipc.fd;
+    for (uint32_t i = 0; i < ipc.number_of_connections; i++) {
+        struct ipc_connection *const connection = &ipc.connections[i];
+        /* a closed side stays readable, do not wait for it */
+        if (!connection->is_input_closed) {
+            FD_SET(connection->fd, read_set);
+        }
+        /* only wait for writing if there is something to write */
+        if (connection->output_length > 0) {
+            FD_SET(connection->fd, write_set);
+        }
+        maximum = MAX(maximum, connection->fd);
+    }
+    return maximum;
+}
+
+/* Send as much of the queued output of @connection as possible.
+ *
+ * @return ERROR if the connection broke.
+ */
+static int flush_output(struct ipc_connection *connection)
+{
+    ssize_t count;
+
+    while (connection->output_length > 0) {
+        count = send(connection->fd, connection->output,
+                connection->output_length, MSG_NOSIGNAL);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            return ERROR;
+        }
+        connection->output_length -= count;
+        memmove(connection->output, &connection->output[count],
+                connection->output_length);
+    }
+    return OK;
+}
+
+/* Queue @length bytes of @data to be sent to @connection.
+ *
+ * @return ERROR if the client is not reading and its output overflows.
+ */
+static int queue_output(struct ipc_connection *connection, const char *data,
+        size_t length)
+{
+    if (connection->output_length + length > IPC_MAXIMUM_OUTPUT_LENGTH) {
+        LOG_ERROR("client %d is not reading its replies\n", connection->fd);
+        return ERROR;
+    }
+
+    RESIZE(connection->output, connection->output_length + length);
+    memcpy(&connection->output[connection->output_length], data, length);
+    connection->output_length += length;
+    return flush_output(connection);
+}
+
+/* Subscribe @connection to the space separated event names in @names.
+ *
+ * @return false if an event name is unknown.
+ */
+static bool subscribe_connection(struct ipc_connection *connection,
+        const char *names)
+{
+    const char *end;
+    size_t length;
+    ipc_event_t event;
+
+    while (names[0] == ' ') {
+        names++;
+    }
+
+    /* subscribe to everything */
+    if (names[0] == '\0') {
+        connection->subscriptions = (1 << IPC_EVENT_MAX) - 1;
+        return true;
+    }
+
+    while (names[0] != '\0') {
+        end = strchr(names, ' ');
+        if (end == NULL) {
+            end = &names[strlen(names)];
+        }
+        length = end - names;
+
+        for (event = 0; event < IPC_EVENT_MAX; event++) {
+            if (strlen(ipc_event_names[event]) == length &&
+                    strncmp(ipc_event_names[event], names, length) == 0) {
+                break;
+            }
+        }
+        if (event == IPC_EVENT_MAX) {
+            LOG_ERROR("client %d subscribed to unknown event %.*s\n",
+                    connection->fd, (int) length, names);
+            return false;
+        }
+        connection->subscriptions |= 1 << event;
+
+        names = end;
+        while (names[0] == ' ') {
+            names++;
+        }
+    }
+    return true;
+}
+
+/* Get the stream the output of the running command goes to. */
+FILE *get_command_output(void)
+{
+    if (!ipc.is_running_command) {
+        return stderr;
+    }
+
+    /* only create the stream for commands that have output */
+    if (ipc.command_output == NULL) {
+        ipc.command_output = open_memstream(&ipc.command_output_data,
+                &ipc.command_output_size);
+        if (ipc.command_output == NULL) {
+            return stderr;
+        }
+    }
+    return ipc.command_output;
+}
+
+/* Run @command and queue the reply for @connection. */
+static int run_connection_command(struct ipc_connection *connection,
+        const char *command)
+{
+    bool result;
+    int status;
+
+    LOG("client %d sent command: %s\n", connection->fd, command);
+    if (strncmp(command, "subscribe", strlen("subscribe")) == 0 &&
+            (command[strlen("subscribe")] == '\0' ||
+             command[strlen("subscribe")] == ' ')) {
+        result = subscribe_connection(connection,
+                &command[strlen("subscribe")]);
+    } else {
+        ipc.is_running_command = true;
+        result = run_command(command);
+        ipc.is_running_command = false;
+    }
+
+    /* send the output of the command before its result */
+    if (ipc.command_output != NULL) {
+        fclose(ipc.command_output);
+        ipc.command_output = NULL;
+        status = queue_output(connection, ipc.command_output_data,
+                ipc.command_output_size);
+        free(ipc.command_output_data);
+        if (status != OK) {
+            return status;
+        }
+    }
+
+    if (result) {
+        return queue_output(connection, "true\n", strlen("true\n"));
+    } else {
+        return queue_output(connection, "false\n", strlen("false\n"));
+    }
+}
+
+/* Read from @connection and run all complete commands.
+ *
+ * @return ERROR if the connection should be closed.
+ */
+static int receive_commands(struct ipc_connection *connection)
+{
+    ssize_t count;
+    char *line;
+    char *end;
+
+    count = read(connection->fd, &connection->input[connection->input_length],
+            sizeof(connection->input) - connection->input_length);
+    if (count < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+            return OK;
+        }
+        return ERROR;
+    }
+
+    /* the client closed its side, run what is left over and close once the
+     * replies are sent
+     */
+    if (count == 0) {
+        connection->is_input_closed = true;
+        if (connection->input_length > 0) {
+            connection->input[connection->input_length] = '\0';
+            connection->input_length = 0;
+            return run_connection_command(connection, connection->input);
+        }
+        return OK;
+    }
+
+    connection->input_length += count;
+
+    /* run all complete commands */
+    line = connection->input;
+    while (end = memchr(line, '\n',
+                    &connection->input[connection->input_length] - line),
+            end != NULL) {
+        end[0] = '\0';
+        if (run_connection_command(connection, line) != OK) {
+            return ERROR;
+        }
+        line = end + 1;
+    }
+
+    /* move the incomplete command to the front */
+    connection->input_length -= line - connection->input;
+    memmove(connection->input, line, connection->input_length);
+
+    /* leave room for the null terminator */
+    if (connection->input_length >= sizeof(connection->input) - 1) {
+        LOG_ERROR("client %d sent a command that is too long\n",
+                connection->fd);
+        return ERROR;
+    }
+    return OK;
+}
+
+/* Check if the peer of @fd is run by the same user as fensterchef. */
+static bool is_peer_trusted(int fd)
+{
+    struct ucred credentials;
+    socklen_t length = sizeof(credentials);
+
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) == -1) {
+        return false;
+    }
+    return credentials.uid == getuid();
+}
+
+/* Accept all pending connections on the socket. */
+static void accept_connections(void)
+{
+    int fd;
+    struct ipc_connection *connection;
+
+    while (fd = accept(ipc.fd, NULL, NULL), fd != -1) {
+        if (!is_peer_trusted(fd)) {
+            LOG_ERROR("rejecting client of another user\n");
+            close(fd);
+            continue;
+        }
+
+        if (ipc.number_of_connections == IPC_MAXIMUM_CONNECTIONS) {
+            LOG_ERROR("too many clients, rejecting new client\n");
+            close(fd);
+            continue;
+        }
+
+        if (set_descriptor_flags(fd) != OK) {
+            LOG_ERROR("could not configure client socket: %s\n",
+                    strerror(errno));
+            close(fd);
+            continue;
+        }
+
+        connection = &ipc.connections[ipc.number_of_connections];
+        connection->fd = fd;
+        connection->input_length = 0;
+        connection->output = NULL;
+        connection->output_length = 0;
+        connection->subscriptions = 0;
+        connection->dropped_events = 0;
+        connection->is_input_closed = false;
+        ipc.number_of_connections++;
+
+        LOG("client %d connected\n", fd);
+    }
+}
+
+/* Accept new connections, run received commands and send queued replies for
+ * all file descriptors that are ready.
+ */
+void handle_ipc_file_descriptors(const fd_set *read_set,
+        const fd_set *write_set)
+{
+    struct ipc_connection *connection;
+    int result;
+
+    if (ipc.fd == -1) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < ipc.number_of_connections; ) {
+        connection = &ipc.connections[i];
+
+        result = OK;
+        if (FD_ISSET(connection->fd, read_set)) {
+            result = receive_commands(connection);
+        }
+        if (result == OK && FD_ISSET(connection->fd, write_set)) {
+            result = flush_output(connection);
+        }
+        if (connection->is_input_closed && connection->output_length == 0) {
+            result = ERROR;
+        }
+
+        if (result != OK) {
+            LOG("client %d disconnected\n", connection->fd);
+            close_connection(i);
+        } else {
+            i++;
+        }
+    }
+
+    /* accept after handling the connections so that the new connections are
+     * not checked against the sets
+     */
+    if (FD_ISSET(ipc.fd, read_set)) {
+        accept_connections();
+    }
+}
+
+/* Append @length bytes of @data to the output of @connection without sending
+ * it.
+ *
+ * @return false if there is not enough space.
+ */
+static bool append_event_output(struct ipc_connection *connection,
+        const char *data, size_t length)
+{
+    if (connection->output_length + length > IPC_MAXIMUM_OUTPUT_LENGTH) {
+        return false;
+    }
+    RESIZE(connection->output, connection->output_length + length);
+    memcpy(&connection->output[connection->output_length], data, length);
+    connection->output_length += length;
+    return true;
+}
+
+/* Append the line telling @connection how many events were dropped. */
+static void append_dropped_events(struct ipc_connection *connection)
+{
+    char line[32];
+    int length;
+
+    if (connection->dropped_events == 0) {
+        return;
+    }
+
+    length = snprintf(line, sizeof(line), "dropped %" PRIu32 "\n",
+            connection->dropped_events);
+    if (append_event_output(connection, line, length)) {
+        connection->dropped_events = 0;
+    }
+}
+
+/* Queue a line for all clients subscribed to @event. */
+void publish_ipc_event(ipc_event_t event, const char *format, ...)
+{
+    char line[256];
+    int length;
+    va_list list;
+    bool is_formatted = false;
+
+    for (uint32_t i = 0; i < ipc.number_of_connections; i++) {
+        struct ipc_connection *const connection = &ipc.connections[i];
+
+        if (!(connection->subscriptions & (1 << event))) {
+            continue;
+        }
+
+        /* only format the line when there is a subscriber */
+        if (!is_formatted) {
+            length = snprintf(line, sizeof(line), "%s ",
+                    ipc_event_names[event]);
+            va_start(list, format);
+            length += vsnprintf(&line[length], sizeof(line) - length - 1,
+                    format, list);
+            va_end(list);
+            length = MIN(length, (int) sizeof(line) - 2);
+            line[length++] = '\n';
+            is_formatted = true;
+        }
+
+        /* a line can only be dropped if the previous lines were sent */
+        append_dropped_events(connection);
+        if (connection->dropped_events > 0 ||
+                !append_event_output(connection, line, length)) {
+            connection->dropped_events++;
+        }
+    }
+}
+
+/* Send as much of the queued lines to all clients as possible. */
+void flush_ipc_events(void)
+{
+    for (uint32_t i = 0; i < ipc.number_of_connections; ) {
+        struct ipc_connection *const connection = &ipc.connections[i];
+
+        if (flush_output(connection) != OK ||
+                (connection->is_input_closed &&
+                 connection->output_length == 0)) {
+            LOG("client %d disconnected\n", connection->fd);
+            close_connection(i);
+            continue;
+        }
+        append_dropped_events(connection);
+        i++;
+    }
+}
+
+/* Connect to the socket of a running fensterchef instance, send @command and
+ * wait for the reply.
+ */
+int send_ipc_command(const char *command)
+{
+    struct sockaddr_un address;
+    int fd;
+    char *line;
+    const char *data;
+    char buffer[256];
+    ssize_t count;
+    size_t length;
+
+    if (get_socket_path(&address) != OK) {
+        return ERROR;
+    }
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+        return ERROR;
+    }
+
+    if (connect(fd, (struct sockaddr*) &address, sizeof(address)) == -1) {
+        close(fd);
+        return ERROR;
+    }
+
+    /* send the command as a complete line and signal that nothing more will
+     * come
+     */
+    line = xasprintf("%s\n", command);
+    data = line;
+    length = strlen(line);
+    while (length > 0) {
+        count = send(fd, data, length, MSG_NOSIGNAL);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "fensterchef command: could not send command: %s\n",
+                    strerror(errno));
+            /* still return OK, parts of the command might have been run */
+            free(line);
+            close(fd);
+            return OK;
+        }
+        data += count;
+        length -= count;
+    }
+    free(line);
+    shutdown(fd, SHUT_WR);
+
+    /* print all replies */
+    while (count = read(fd, buffer, sizeof(buffer)), count != 0) {
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        fwrite(buffer, 1, count, stdout);
+    }
+
+    close(fd);
+    return OK;
+}
@@ -0,0 +1,357 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xcb/randr.h>
+#include <xcb/xcb_event.h>
+
+#include "event.h"
+#include "latency.h"
+#include "log.h"
+#include "utility.h"
+
+/* the names of all operations that are not events */
+static const char *operation_names[] = {
+#define X(operation, name) [operation - LATENCY_EVENT_TYPES] = name,
+    DEFINE_ALL_LATENCY_OPERATIONS
+#undef X
+};
+
+/* the histograms of all events and operations */
+static struct latency_histogram {
+    /* bucket `i` counts durations of at least 2^i and less than 2^(i + 1)
+     * nanoseconds
+     */
+    uint32_t buckets[LATENCY_BUCKETS];
+    /* the number of durations recorded */
+    uint32_t count;
+    /* the sum of all durations */
+    uint64_t total;
+    /* the longest duration */
+    uint64_t maximum;
+} histograms[LATENCY_MAX];
+
+/* the time spent waiting for replies */
+struct round_trip_account {
+    /* the number of round trips */
+    uint32_t count;
+    /* the total time blocked */
+    uint64_t time;
+};
+
+/* the round trips of each call site */
+static struct round_trip_site {
+    /* the file of the call site or `NULL` if this entry is free */
+    const char *file;
+    /* the line within @file */
+    int line;
+    /* the accounted round trips */
+    struct round_trip_account account;
+} round_trip_sites[ROUND_TRIP_MAXIMUM_SITES];
+
+/* the number of used entries in `round_trip_sites` */
+static uint32_t number_of_round_trip_sites;
+
+/* the round trips of each action */
+static struct round_trip_account action_round_trips[ACTION_MAX];
+
+/* the action round trips are accounted to */
+action_t round_trip_action;
+
+/* the time the current round trip started */
+static uint64_t round_trip_start;
+
+/* Add the time from @start until now to the histogram at @index. */
+uint64_t record_latency(uint32_t index, uint64_t start)
+{
+    uint64_t now;
+    uint64_t duration;
+    struct latency_histogram *histogram;
+    uint32_t bucket = 0;
+
+    now = get_monotonic_time();
+    duration = now - start;
+
+    histogram = &histograms[index];
+    while (bucket < LATENCY_BUCKETS - 1 && (duration >> (bucket + 1)) != 0) {
+        bucket++;
+    }
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    histogram->total += duration;
+    histogram->maximum = MAX(histogram->maximum, duration);
+    return now;
+}
+
+/* Start measuring a round trip. */
+void begin_round_trip(void)
+{
+    round_trip_start = get_monotonic_time();
+}
+
+/* Find the entry of the call site at @file and @line.
+ *
+ * @return the entry or a free entry where it can be placed.
+ */
+static struct round_trip_site *find_round_trip_site(const char *file,
+        int line)
+{
+    uint32_t hash;
+    uint32_t index;
+    struct round_trip_site *site;
+
+    /* FNV-1a hash of the file and line */
+    hash = UINT32_C(2166136261);
+    for (const char *c = file; c[0] != '\0'; c++) {
+        hash ^= (uint8_t) c[0];
+        hash *= UINT32_C(16777619);
+    }
+    hash ^= line;
+    hash *= UINT32_C(16777619);
+    index = hash & (ROUND_TRIP_MAXIMUM_SITES - 1);
+
+    while (site = &round_trip_sites[index], site->file != NULL) {
+        if (site->line == line && strcmp(site->file, file) == 0) {
+            break;
+        }
+        index = (index + 1) & (ROUND_TRIP_MAXIMUM_SITES - 1);
+    }
+    return site;
+}
+
+/* Account the round trip started by `begin_round_trip()` to @file and @line.
+ */
+static void account_round_trip(const char *file, int line)
+{
+    uint64_t duration;
+    struct round_trip_site *site;
+
+    duration = get_monotonic_time() - round_trip_start;
+
+    site = find_round_trip_site(file, line);
+    /* keep the table at most half full, further sites are only accounted to
+     * the action
+     */
+    if (site->file == NULL &&
+            number_of_round_trip_sites < ROUND_TRIP_MAXIMUM_SITES / 2) {
+        site->file = file;
+        site->line = line;
+        number_of_round_trip_sites++;
+    }
+    if (site->file != NULL) {
+        site->account.count++;
+        site->account.time += duration;
+    }
+
+    action_round_trips[round_trip_action].count++;
+    action_round_trips[round_trip_action].time += duration;
+}
+
+/* Account the round trip started by `begin_round_trip()` to @file and @line.
+ */
+void *end_round_trip(const char *file, int line, void *reply)
+{
+    account_round_trip(file, line);
+    return reply;
+}
+
+/* Same as `end_round_trip()` but for a @status. */
+int end_round_trip_status(const char *file, int line, int status)
+{
+    account_round_trip(file, line);
+    return status;
+}
+
+/* Get a readable name for the histogram at @index. */
+static const char *get_latency_name(uint32_t index, char *buffer, size_t size)
+{
+    const char *label;
+
+    if (index >= LATENCY_EVENT_TYPES) {
+        return operation_names[index - LATENCY_EVENT_TYPES];
+    }
+
+    if (randr_event_base > 0 && index ==
+            (uint32_t) randr_event_base + XCB_RANDR_SCREEN_CHANGE_NOTIFY) {
+        return "RandrScreenChangeNotify";
+    }
+    if (randr_event_base > 0 &&
+            index == (uint32_t) randr_event_base + XCB_RANDR_NOTIFY) {
+        return "RandrNotify";
+    }
+
+    label = xcb_event_get_label(index);
+    if (label != NULL) {
+        return label;
+    }
+    snprintf(buffer, size, "EVENT[%" PRIu32 "]", index);
+    return buffer;
+}
+
+/* Format @duration in nanoseconds with a fitting unit into @buffer. */
+static int format_duration(uint64_t duration, char *buffer, size_t size)
+{
+    if (duration < 1000) {
+        return snprintf(buffer, size, "%" PRIu64 "ns", duration);
+    }
+    if (duration < 1000000) {
+        return snprintf(buffer, size, "%" PRIu64 "us", duration / 1000);
+    }
+    if (duration < 1000000000) {
+        return snprintf(buffer, size, "%" PRIu64 "ms", duration / 1000000);
+    }
+    return snprintf(buffer, size, "%" PRIu64 "s", duration / 1000000000);
+}
+
+/* Get the upper bound of the bucket the @percent percentile falls into. */
+static uint64_t get_percentile(const struct latency_histogram *histogram,
+        uint32_t percent)
+{
+    uint64_t needed;
+    uint64_t count = 0;
+    uint32_t bucket;
+
+    needed = ((uint64_t) histogram->count * percent + 99) / 100;
+    for (bucket = 0; bucket < LATENCY_BUCKETS - 1; bucket++) {
+        count += histogram->buckets[bucket];
+        if (count >= needed) {
+            break;
+        }
+    }
+    return MIN((uint64_t) 2 << bucket, histogram->maximum);
+}
+
+/* Compare two round trip sites by their time, longest first. */
+static int compare_round_trip_sites(const void *a, const void *b)
+{
+    const struct round_trip_site *const *site_a = a, *const *site_b = b;
+
+    if ((*site_a)->account.time != (*site_b)->account.time) {
+        return (*site_a)->account.time < (*site_b)->account.time ? 1 : -1;
+    }
+    return 0;
+}
+
+/* Compare two actions by the time of their round trips, longest first. */
+static int compare_action_round_trips(const void *a, const void *b)
+{
+    const action_t *action_a = a, *action_b = b;
+    const uint64_t time_a = action_round_trips[*action_a].time;
+    const uint64_t time_b = action_round_trips[*action_b].time;
+
+    if (time_a != time_b) {
+        return time_a < time_b ? 1 : -1;
+    }
+    return 0;
+}
+
+/* Write a single round trip @account with @name to @file. */
+static void dump_round_trip_account(FILE *file, const char *name,
+        const struct round_trip_account *account)
+{
+    char total[16], mean[16];
+
+    format_duration(account->time, total, sizeof(total));
+    format_duration(account->time / account->count, mean, sizeof(mean));
+    print_formatted(file, "%s: %" PRIu32 " %s %s\n",
+            name, account->count, total, mean);
+}
+
+/* Write the call sites and actions that blocked the longest to @file. */
+static void dump_round_trips(FILE *file)
+{
+    const struct round_trip_site *sites[ROUND_TRIP_MAXIMUM_SITES];
+    uint32_t number_of_sites = 0;
+    action_t actions[ACTION_MAX];
+    uint32_t number_of_actions = 0;
+    char name[64];
+
+    for (uint32_t i = 0; i < ROUND_TRIP_MAXIMUM_SITES; i++) {
+        if (round_trip_sites[i].file != NULL) {
+            sites[number_of_sites] = &round_trip_sites[i];
+            number_of_sites++;
+        }
+    }
+    qsort(sites, number_of_sites, sizeof(*sites), compare_round_trip_sites);
+
+    print_formatted(file, "round trips by call site (count, total, mean):\n");
+    for (uint32_t i = 0; i < MIN(number_of_sites, ROUND_TRIP_REPORTED_SITES);
+            i++) {
+        snprintf(name, sizeof(name), "%s:%d", sites[i]->file, sites[i]->line);
+        dump_round_trip_account(file, name, &sites[i]->account);
+    }
+
+    for (action_t i = ACTION_NULL; i < ACTION_MAX; i++) {
+        if (action_round_trips[i].count > 0) {
+            actions[number_of_actions] = i;
+            number_of_actions++;
+        }
+    }
+    qsort(actions, number_of_actions, sizeof(*actions),
+            compare_action_round_trips);
+
+    print_formatted(file, "round trips by action (count, total, mean):\n");
+    for (uint32_t i = 0; i < number_of_actions; i++) {
+        dump_round_trip_account(file, actions[i] == ACTION_NULL ?
+                    "outside of actions" : action_to_string(actions[i]),
+                &action_round_trips[actions[i]]);
+    }
+}
+
+/* Write all histograms that have any entries and the call sites and actions
+ * that blocked the longest on round trips to @file.
+ */
+void dump_latencies(FILE *file)
+{
+    const struct latency_histogram *histogram;
+    char name[32];
+    char line[64 + LATENCY_BUCKETS * 24];
+    int length;
+    char mean[16], median[16], high[16], maximum[16];
+
+    print_formatted(file, "latencies (count, mean, 50th and 99th percentile, "
+            "maximum, histogram):\n");
+    for (uint32_t i = 0; i < LATENCY_MAX; i++) {
+        histogram = &histograms[i];
+        if (histogram->count == 0) {
+            continue;
+        }
+
+        format_duration(histogram->total / histogram->count,
+                mean, sizeof(mean));
+        format_duration(get_percentile(histogram, 50), median, sizeof(median));
+        format_duration(get_percentile(histogram, 99), high, sizeof(high));
+        format_duration(histogram->maximum, maximum, sizeof(maximum));
+        length = snprintf(line, sizeof(line),
+                "%" PRIu32 " %s %s %s %s |",
+                histogram->count, mean, median, high, maximum);
+
+        /* only show the buckets with entries as `<LIMIT:COUNT`, the last
+         * bucket holds all longer durations and is shown as `>=START:COUNT`
+         */
+        for (uint32_t j = 0; j < LATENCY_BUCKETS; j++) {
+            if (histogram->buckets[j] == 0) {
+                continue;
+            }
+            if (j == LATENCY_BUCKETS - 1) {
+                length += snprintf(&line[length], sizeof(line) - length,
+                        " >=");
+                length += format_duration((uint64_t) 1 << j, &line[length],
+                        sizeof(line) - length);
+            } else {
+                length += snprintf(&line[length], sizeof(line) - length,
+                        " <");
+                length += format_duration((uint64_t) 2 << j, &line[length],
+                        sizeof(line) - length);
+            }
+            length += snprintf(&line[length], sizeof(line) - length,
+                    ":%" PRIu32, histogram->buckets[j]);
+        }
+
+        print_formatted(file, "%s: %s\n",
+                get_latency_name(i, name, sizeof(name)), line);
+    }
+
+    dump_round_trips(file);
+}
@@ -1,7 +1,12 @@
+#include <errno.h>
 #include <inttypes.h>
+#include <pthread.h>
+#include <signal.h>
 #include <stdarg.h>
 #include <string.h>
+#include <sys/uio.h>
 #include <time.h>
+#include <unistd.h>
 
 #include <xcb/randr.h>
 #include <xcb/xcb_event.h>
@@ -10,6 +15,7 @@
 #include "action.h"
 #include "event.h"
 #include "frame.h"
+#include "latency.h"
 #include "log.h"
 #include "window.h"
 #include "window_list.h"
@@ -19,6 +25,44 @@
 /* the severity of the logging */
 log_severity_t log_severity = LOG_SEVERITY_INFO;
 
+/* the stream a single line is formatted into, this is a memory stream backed
+ * by `log_line` or standard error output if that stream could not be created
+ */
+static FILE *log_stream;
+
+/* the memory of the line stream */
+static char *log_line;
+/* the size of `log_line` */
+static size_t log_line_size;
+
+/* the ring the event loop pushes formatted lines into and the writer thread
+ * drains to standard error output
+ */
+static struct log_ring {
+    /* the buffered bytes */
+    char data[LOG_RING_SIZE];
+    /* the total number of bytes pushed, only written by the event loop */
+    size_t head;
+    /* the total number of bytes written, only written by the writer thread */
+    size_t tail;
+    /* the number of lines dropped since the last successful push */
+    uint32_t number_of_dropped_lines;
+    /* if the writer thread is running */
+    bool is_running;
+    /* if the writer thread waits for the condition */
+    int is_sleeping;
+    /* if the writer thread should exit once the ring is empty */
+    int is_stopping;
+    /* the writer thread */
+    pthread_t thread;
+    /* mutex and condition used to wake up the writer thread */
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+} log_ring = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .condition = PTHREAD_COND_INITIALIZER,
+};
+
 /***********************/
 /** String conversion **/
 
@@ -260,45 +304,45 @@ static const char *gravity_to_string(xcb_gravity_t gravity)
 static void log_boolean(bool boolean)
 {
     fputs(boolean ? COLOR(GREEN) "true" CLEAR_COLOR :
-            COLOR(RED) "false" CLEAR_COLOR, stderr);
+            COLOR(RED) "false" CLEAR_COLOR, log_stream);
 }
 
 static void log_hexadecimal(uint32_t x)
 {
-    fprintf(stderr, COLOR(GREEN) "%#" PRIx32 CLEAR_COLOR, x);
+    fprintf(log_stream, COLOR(GREEN) "%#" PRIx32 CLEAR_COLOR, x);
 }
 
 static void log_point(int32_t x, int32_t y)
 {
-    fprintf(stderr, COLOR(GREEN) "%" PRId32 "+%" PRId32 CLEAR_COLOR, x, y);
+    fprintf(log_stream, COLOR(GREEN) "%" PRId32 "+%" PRId32 CLEAR_COLOR, x, y);
 }
 
 static void log_rectangle(int32_t x, int32_t y, uint32_t width, uint32_t height)
 {
-    fprintf(stderr, COLOR(GREEN) "%" PRId32 "+%" PRId32
+    fprintf(log_stream, COLOR(GREEN) "%" PRId32 "+%" PRId32
                 "+%" PRIu32 "x%" PRIu32  CLEAR_COLOR,
             x, y, width, height);
 }
 
 static void log_size(uint32_t width, uint32_t height)
 {
-    fprintf(stderr, COLOR(GREEN) "%" PRId32 "x%" PRId32 CLEAR_COLOR,
+    fprintf(log_stream, COLOR(GREEN) "%" PRId32 "x%" PRId32 CLEAR_COLOR,
             width, height);
 }
 
 static void log_integer(int32_t x)
 {
-    fprintf(stderr, COLOR(GREEN) "%" PRId32 CLEAR_COLOR, x);
+    fprintf(log_stream, COLOR(GREEN) "%" PRId32 CLEAR_COLOR, x);
 }
 
 static void log_unsigned(uint32_t x)
 {
-    fprintf(stderr, COLOR(GREEN) "%" PRIu32 CLEAR_COLOR, x);
+    fprintf(log_stream, COLOR(GREEN) "%" PRIu32 CLEAR_COLOR, x);
 }
 
 static void log_unsigned_pair(uint32_t x, uint32_t y)
 {
-    fprintf(stderr, COLOR(GREEN) "%" PRIu32 ",%" PRIu32 CLEAR_COLOR, x, y);
+    fprintf(log_stream, COLOR(GREEN) "%" PRIu32 ",%" PRIu32 CLEAR_COLOR, x, y);
 }
 
 static void log_button(xcb_button_t button)
@@ -307,9 +351,9 @@ static void log_button(xcb_button_t button)
 
     string = button_to_string(button);
     if (string == NULL) {
-        fprintf(stderr, COLOR(CYAN) "X%u" CLEAR_COLOR, button - 7);
+        fprintf(log_stream, COLOR(CYAN) "X%u" CLEAR_COLOR, button - 7);
     } else {
-        fprintf(stderr, COLOR(CYAN) "%s" CLEAR_COLOR, string);
+        fprintf(log_stream, COLOR(CYAN) "%s" CLEAR_COLOR, string);
     }
 }
 
@@ -317,13 +361,13 @@ static void log_source(uint32_t source)
 {
     switch (source) {
     case 1:
-        fputs(COLOR(CYAN) "client" CLEAR_COLOR, stderr);
+        fputs(COLOR(CYAN) "client" CLEAR_COLOR, log_stream);
         break;
     case 2:
-        fputs(COLOR(CYAN) "pager" CLEAR_COLOR, stderr);
+        fputs(COLOR(CYAN) "pager" CLEAR_COLOR, log_stream);
         break;
     default:
-        fputs(COLOR(CYAN) "legacy" CLEAR_COLOR, stderr);
+        fputs(COLOR(CYAN) "legacy" CLEAR_COLOR, log_stream);
         break;
     }
 }
@@ -334,9 +378,9 @@ static void log_gravity(xcb_gravity_t gravity)
 
     string = gravity_to_string(gravity);
     if (string == NULL) {
-        fprintf(stderr, COLOR(GREEN) "%u" CLEAR_COLOR, gravity);
+        fprintf(log_stream, COLOR(GREEN) "%u" CLEAR_COLOR, gravity);
     } else {
-        fprintf(stderr, COLOR(CYAN) "%s" CLEAR_COLOR, string);
+        fprintf(log_stream, COLOR(CYAN) "%s" CLEAR_COLOR, string);
     }
 }
 
@@ -346,9 +390,9 @@ static void log_direction(wm_move_resize_direction_t direction)
 
     string = direction_to_string(direction);
     if (string == NULL) {
-        fprintf(stderr, COLOR(GREEN) "%u" CLEAR_COLOR, direction);
+        fprintf(log_stream, COLOR(GREEN) "%u" CLEAR_COLOR, direction);
     } else {
-        fprintf(stderr, COLOR(CYAN) "%s" CLEAR_COLOR, string);
+        fprintf(log_stream, COLOR(CYAN) "%s" CLEAR_COLOR, string);
     }
 }
 
@@ -361,117 +405,120 @@ static void log_modifiers(uint32_t mask)
     };
     int modifier_count = 0;
 
-    fputs(COLOR(MAGENTA), stderr);
+    fputs(COLOR(MAGENTA), log_stream);
     for (const char **modifier = modifiers; mask != 0; mask >>= 1, modifier++) {
         if ((mask & 1)) {
             if (modifier_count > 0) {
-                fputs(CLEAR_COLOR "+" COLOR(MAGENTA), stderr);
+                fputs(CLEAR_COLOR "+" COLOR(MAGENTA), log_stream);
             }
-            fputs(*modifier, stderr);
+            fputs(*modifier, log_stream);
             modifier_count++;
         }
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 static void log_xcb_window(xcb_window_t xcb_window)
 {
     log_hexadecimal(xcb_window);
-    fputs(COLOR(YELLOW), stderr);
+    /* without a connection (when decoding a trace), the special windows do not
+     * exist and are all `XCB_NONE`
+     */
+    if (xcb_window == XCB_NONE || connection == NULL) {
+        return;
+    }
+    fputs(COLOR(YELLOW), log_stream);
     if (xcb_window == wm_check_window) {
-        fputs("<check>", stderr);
+        fputs("<check>", log_stream);
     } else if (xcb_window == window_list.client.id) {
-        fputs("<window list>", stderr);
+        fputs("<window list>", log_stream);
     } else if (xcb_window == notification.id) {
-        fputs("<notification>", stderr);
-    } else if (xcb_window == screen->root) {
-        fputs("<root>", stderr);
+        fputs("<notification>", log_stream);
+    } else if (screen != NULL && xcb_window == screen->root) {
+        fputs("<root>", log_stream);
     } else {
-        for (Window *window = Window_first; window != NULL;
-                window = window->next) {
-            if (window->client.id == xcb_window) {
-                fprintf(stderr, "<%" PRIu32 ">", window->number);
-                break;
-            }
+        Window *const window = get_window_of_xcb_window(xcb_window);
+        if (window != NULL) {
+            fprintf(log_stream, "<%" PRIu32 ">", window->number);
         }
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 static void log_motion(xcb_motion_t motion)
 {
-    fputs(COLOR(CYAN), stderr);
+    fputs(COLOR(CYAN), log_stream);
     switch (motion) {
     case XCB_MOTION_NORMAL:
-        fputs("normal", stderr);
+        fputs("normal", log_stream);
         break;
     case XCB_MOTION_HINT:
-        fputs("hint", stderr);
+        fputs("hint", log_stream);
         break;
     default:
-        fprintf(stderr, "%u", motion);
+        fprintf(log_stream, "%u", motion);
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 static void log_notify_detail(xcb_notify_detail_t detail)
 {
     const char *string;
 
-    fputs(COLOR(CYAN), stderr);
+    fputs(COLOR(CYAN), log_stream);
     string = notify_detail_to_string(detail);
     if (string == NULL) {
-        fprintf(stderr, "%u", detail);
+        fprintf(log_stream, "%u", detail);
     } else {
-        fputs(string, stderr);
+        fputs(string, log_stream);
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 static void log_notify_mode(xcb_notify_mode_t mode)
 {
     const char *string;
 
-    fputs(COLOR(CYAN), stderr);
+    fputs(COLOR(CYAN), log_stream);
     string = notify_mode_to_string(mode);
     if (string == NULL) {
-        fprintf(stderr, "%u", mode);
+        fprintf(log_stream, "%u", mode);
     } else {
-        fputs(string, stderr);
+        fputs(string, log_stream);
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 static void log_place(xcb_place_t place)
 {
-    fputs(COLOR(CYAN), stderr);
+    fputs(COLOR(CYAN), log_stream);
     switch (place) {
     case XCB_PLACE_ON_TOP:
-        fputs("on top", stderr);
+        fputs("on top", log_stream);
         break;
     case XCB_PLACE_ON_BOTTOM:
-        fputs("on bottom", stderr);
+        fputs("on bottom", log_stream);
         break;
     default:
-        fprintf(stderr, "%u", place);
+        fprintf(log_stream, "%u", place);
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 static void log_property_state(uint8_t state)
 {
-    fputs(COLOR(CYAN), stderr);
+    fputs(COLOR(CYAN), log_stream);
     switch (state) {
     case XCB_PROPERTY_NEW_VALUE:
-        fputs("new value", stderr);
+        fputs("new value", log_stream);
         break;
     case XCB_PROPERTY_DELETE:
-        fputs("delete", stderr);
+        fputs("delete", log_stream);
         break;
     default:
-        fprintf(stderr, "%" PRIu8, state);
+        fprintf(log_stream, "%" PRIu8, state);
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 static void log_atom(xcb_atom_t atom)
@@ -480,42 +527,48 @@ static void log_atom(xcb_atom_t atom)
     xcb_get_atom_name_cookie_t name_cookie;
     xcb_get_atom_name_reply_t *name;
 
-    fputs(COLOR(CYAN), stderr);
+    fputs(COLOR(CYAN), log_stream);
     atom_string = atom_to_string(atom);
     if (atom_string == NULL) {
-        name_cookie = xcb_get_atom_name(connection, atom);
-        name = xcb_get_atom_name_reply(connection, name_cookie, NULL);
+        /* there is no connection when decoding a trace */
+        if (connection == NULL) {
+            name = NULL;
+        } else {
+            name_cookie = xcb_get_atom_name(connection, atom);
+            name = ROUND_TRIP(xcb_get_atom_name_reply(connection,
+                        name_cookie, NULL));
+        }
         if (name == NULL) {
-            fprintf(stderr, "%" PRIu32, atom);
+            fprintf(log_stream, "%" PRIu32, atom);
         } else {
-            fprintf(stderr, "%.*s", xcb_get_atom_name_name_length(name),
+            fprintf(log_stream, "%.*s", xcb_get_atom_name_name_length(name),
                     xcb_get_atom_name_name(name));
             free(name);
         }
-        fputs(COLOR(RED) "<not known>", stderr);
+        fputs(COLOR(RED) "<not known>", log_stream);
     } else {
-        fprintf(stderr, "%s", atom_string);
+        fprintf(log_stream, "%s", atom_string);
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 static void log_visibility(xcb_visibility_t visibility)
 {
-    fputs(COLOR(CYAN), stderr);
+    fputs(COLOR(CYAN), log_stream);
     switch (visibility) {
     case XCB_VISIBILITY_UNOBSCURED:
-        fputs("unobscured", stderr);
+        fputs("unobscured", log_stream);
         break;
     case XCB_VISIBILITY_PARTIALLY_OBSCURED:
-        fputs("partially obscured", stderr);
+        fputs("partially obscured", log_stream);
         break;
     case XCB_VISIBILITY_FULLY_OBSCURED:
-        fputs("fully obscured", stderr);
+        fputs("fully obscured", log_stream);
         break;
     default:
-        fprintf(stderr, "%u", visibility);
+        fprintf(log_stream, "%u", visibility);
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 static void log_configure_mask(uint32_t mask)
@@ -526,118 +579,118 @@ static void log_configure_mask(uint32_t mask)
     };
     int flag_count = 0;
 
-    fputs(COLOR(MAGENTA), stderr);
+    fputs(COLOR(MAGENTA), log_stream);
     for (const char **flag = flags; mask != 0; mask >>= 1, flag++) {
         if ((mask & 1)) {
             if (flag_count > 0) {
-                fputs(CLEAR_COLOR "+" COLOR(MAGENTA), stderr);
+                fputs(CLEAR_COLOR "+" COLOR(MAGENTA), log_stream);
             }
-            fputs(*flag, stderr);
+            fputs(*flag, log_stream);
             flag_count++;
         }
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 static void log_mapping(xcb_mapping_t mapping)
 {
-    fputs(COLOR(CYAN), stderr);
+    fputs(COLOR(CYAN), log_stream);
     switch (mapping) {
     case XCB_MAPPING_MODIFIER:
-        fputs("modifier", stderr);
+        fputs("modifier", log_stream);
         break;
     case XCB_MAPPING_KEYBOARD:
-        fputs("keyboard", stderr);
+        fputs("keyboard", log_stream);
         break;
     case XCB_MAPPING_POINTER:
-        fputs("pointer", stderr);
+        fputs("pointer", log_stream);
         break;
     default:
-        fprintf(stderr, "%u", mapping);
+        fprintf(log_stream, "%u", mapping);
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 static void log_wm_state(xcb_icccm_wm_state_t state)
 {
-    fputs(COLOR(CYAN), stderr);
+    fputs(COLOR(CYAN), log_stream);
     switch (state) {
     case XCB_ICCCM_WM_STATE_WITHDRAWN:
-        fputs("withdrawn", stderr);
+        fputs("withdrawn", log_stream);
         break;
     case XCB_ICCCM_WM_STATE_NORMAL:
-        fputs("normal", stderr);
+        fputs("normal", log_stream);
         break;
     case XCB_ICCCM_WM_STATE_ICONIC:
-        fputs("iconic", stderr);
+        fputs("iconic", log_stream);
         break;
     default:
-        fprintf(stderr, "%u", state);
+        fprintf(log_stream, "%u", state);
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 static void log_window_mode(window_mode_t mode)
 {
-    fputs(COLOR(CYAN), stderr);
+    fputs(COLOR(CYAN), log_stream);
     switch (mode) {
     case WINDOW_MODE_TILING:
-        fputs("tiling", stderr);
+        fputs("tiling", log_stream);
         break;
     case WINDOW_MODE_FLOATING:
-        fputs("floating", stderr);
+        fputs("floating", log_stream);
         break;
     case WINDOW_MODE_DOCK:
-        fputs("dock", stderr);
+        fputs("dock", log_stream);
         break;
     case WINDOW_MODE_FULLSCREEN:
-        fputs("fullscreen", stderr);
+        fputs("fullscreen", log_stream);
         break;
     case WINDOW_MODE_DESKTOP:
-        fputs("desktop", stderr);
+        fputs("desktop", log_stream);
         break;
     case WINDOW_MODE_MAX:
-        fputs("none", stderr);
+        fputs("none", log_stream);
         break;
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 static void log_connection_error(int error)
 {
-    fputs(COLOR(RED), stderr);
+    fputs(COLOR(RED), log_stream);
     switch (error) {
     case XCB_CONN_ERROR:
-        fputs("socket, pipe or other stream error", stderr);
+        fputs("socket, pipe or other stream error", log_stream);
         break;
     case XCB_CONN_CLOSED_EXT_NOTSUPPORTED:
-        fputs("an extension is not supported", stderr);
+        fputs("an extension is not supported", log_stream);
         break;
     case XCB_CONN_CLOSED_MEM_INSUFFICIENT:
-        fputs("insufficient memory", stderr);
+        fputs("insufficient memory", log_stream);
         break;
     case XCB_CONN_CLOSED_REQ_LEN_EXCEED:
-        fputs("maximum request length exceeded", stderr);
+        fputs("maximum request length exceeded", log_stream);
         break;
     case XCB_CONN_CLOSED_PARSE_ERR:
-        fputs("failed parsing display string", stderr);
+        fputs("failed parsing display string", log_stream);
         break;
     case XCB_CONN_CLOSED_INVALID_SCREEN:
-        fputs("no screen matching the display", stderr);
+        fputs("no screen matching the display", log_stream);
         break;
     case XCB_CONN_CLOSED_FDPASSING_FAILED:
-        fputs("FD passing operation failed", stderr);
+        fputs("FD passing operation failed", log_stream);
         break;
     default:
-        fprintf(stderr, "%d", error);
+        fprintf(log_stream, "%d", error);
     }
-    fputs(CLEAR_COLOR, stderr);
+    fputs(CLEAR_COLOR, log_stream);
 }
 
 /*************************/
 /** Event log functions **/
 
-#define V(string) fputs(", " string "=", stderr)
+#define V(string) fputs(", " string "=", log_stream)
 
 /* Log a RandrScreenChangeNotifyEvent to standard error output. */
 static void log_randr_screen_change_notify_event(
@@ -657,7 +710,7 @@ static void log_generic_error(xcb_generic_error_t *error)
     if (error_label == NULL) {
         V("error_code"); log_unsigned(error->error_code);
     } else {
-        V("error_label"); fprintf(stderr, COLOR(CYAN) "%s" CLEAR_COLOR,
+        V("error_label"); fprintf(log_stream, COLOR(CYAN) "%s" CLEAR_COLOR,
                 error_label);
     }
     V("code"); log_unsigned_pair(error->major_code, error->minor_code);
@@ -732,7 +785,7 @@ static void log_focus_in_event(xcb_focus_in_event_t *event)
 static void log_keymap_notify_event(xcb_keymap_notify_event_t *event)
 {
     (void) event;
-    fprintf(stderr, ", keys=...");
+    fprintf(log_stream, ", keys=...");
 }
 
 /* Log a ExposeEvent to standard error output. */
@@ -957,16 +1010,16 @@ static void log_client_message_event(xcb_client_message_event_t *event)
     } else if (event->type == ATOM(_NET_WM_STATE)) {
         V("data");
         if (event->data.data32[0] >= SIZE(state_strings)) {
-            fprintf(stderr, COLOR(RED) "<misformatted>");
+            fprintf(log_stream, COLOR(RED) "<misformatted>");
         } else {
-            fprintf(stderr, COLOR(CYAN) "%s",
+            fprintf(log_stream, COLOR(CYAN) "%s",
                     state_strings[event->data.data32[0]]);
         }
-        fputc(' ', stderr);
+        fputc(' ', log_stream);
         log_atom(event->data.data32[1]);
     } else {
         V("data32");
-        fprintf(stderr, COLOR(GREEN) "%" PRIu32 " %" PRIu32 " %" PRIu32
+        fprintf(log_stream, COLOR(GREEN) "%" PRIu32 " %" PRIu32 " %" PRIu32
                     " %" PRIu32 " %" PRIu32 CLEAR_COLOR,
                 event->data.data32[0], event->data.data32[1],
                 event->data.data32[2], event->data.data32[3],
@@ -998,35 +1051,35 @@ static void log_event(xcb_generic_event_t *event)
     event_type = (event->response_type & ~0x80);
     if (randr_event_base > 0 &&
             event_type == randr_event_base + XCB_RANDR_SCREEN_CHANGE_NOTIFY) {
-        fputs("RandrScreenChangeNotify", stderr);
+        fputs("RandrScreenChangeNotify", log_stream);
     } else if (randr_event_base > 0 &&
             event_type == randr_event_base + XCB_RANDR_NOTIFY) {
-        fputs("RandrNotify", stderr);
+        fputs("RandrNotify", log_stream);
     } else if (xcb_event_get_label(event_type) != NULL) {
-        fputs(xcb_event_get_label(event_type), stderr);
+        fputs(xcb_event_get_label(event_type), log_stream);
     } else {
-        fprintf(stderr, "EVENT[%" PRIu8 "]", event_type);
+        fprintf(log_stream, "EVENT[%" PRIu8 "]", event_type);
     }
 
     if (event_type == XCB_GE_GENERIC) {
         xcb_ge_generic_event_t *const generic_event =
             (xcb_ge_generic_event_t*) event;
         if (generic_event->extension >= SIZE(generic_event_strings)) {
-            fprintf(stderr, "EVENT[%" PRIu8 "]", event_type);
+            fprintf(log_stream, "EVENT[%" PRIu8 "]", event_type);
         } else {
-            fprintf(stderr, "%s",
+            fprintf(log_stream, "%s",
                     generic_event_strings[generic_event->extension]);
         }
     }
 
-    fprintf(stderr, "(sequence=");
+    fprintf(log_stream, "(sequence=");
     log_unsigned(event->sequence);
 
     if (randr_event_base > 0 &&
             event_type == randr_event_base + XCB_RANDR_SCREEN_CHANGE_NOTIFY) {
         log_randr_screen_change_notify_event(
                 (xcb_randr_screen_change_notify_event_t*) event);
-        fputs(")", stderr);
+        fputs(")", log_stream);
         return;
     }
 
@@ -1156,33 +1209,34 @@ static void log_event(xcb_generic_event_t *event)
         log_ge_generic_event((xcb_ge_generic_event_t*) event);
         break;
     }
-    fputs(")", stderr);
+    fputs(")", log_stream);
 }
 
 /* Log an xcb error to standard error output. */
 static void log_error(xcb_generic_error_t *error)
 {
-    fprintf(stderr, "(sequence=");
+    fprintf(log_stream, "(sequence=");
     log_integer(error->sequence);
     log_generic_error(error);
-    fputs(")", stderr);
+    fputs(")", log_stream);
 }
 
 /* Log a window to standard error output. */
 static void log_window(const Window *window)
 {
     log_hexadecimal(window->client.id);
-    fprintf(stderr, COLOR(YELLOW) "<%" PRIu32 ">" CLEAR_COLOR, window->number);
+    fprintf(log_stream, COLOR(YELLOW) "<%" PRIu32 ">" CLEAR_COLOR,
+            window->number);
 }
 
 /* Log a window to standard error output. */
 static void log_frame(const Frame *frame)
 {
-    fputs(COLOR(MAGENTA) "[", stderr);
+    fputs(COLOR(MAGENTA) "[", log_stream);
     log_rectangle(frame->x, frame->y, frame->width, frame->height);
-    fputs(COLOR(MAGENTA) "]" CLEAR_COLOR, stderr);
+    fputs(COLOR(MAGENTA) "]" CLEAR_COLOR, log_stream);
     if (frame->number > 0) {
-        fprintf(stderr, COLOR(YELLOW) "<%" PRIu32 ">" CLEAR_COLOR,
+        fprintf(log_stream, COLOR(YELLOW) "<%" PRIu32 ">" CLEAR_COLOR,
                 frame->number);
     }
 }
@@ -1196,23 +1250,23 @@ static void log_data_type(data_type_t type, const GenericData *data)
         break;
 
     case DATA_TYPE_BOOLEAN:
-        fputc(' ', stderr);
+        fputc(' ', log_stream);
         log_boolean(data->boolean);
         break;
 
     case DATA_TYPE_STRING:
-        fputc(' ', stderr);
-        fprintf(stderr, COLOR(GREEN) "%s" CLEAR_COLOR,
+        fputc(' ', log_stream);
+        fprintf(log_stream, COLOR(GREEN) "%s" CLEAR_COLOR,
                 (char*) data->string);
         break;
 
     case DATA_TYPE_INTEGER:
-        fputc(' ', stderr);
+        fputc(' ', log_stream);
         log_integer(data->integer);
         break;
 
     case DATA_TYPE_QUAD:
-        fprintf(stderr, COLOR(GREEN)
+        fprintf(log_stream, COLOR(GREEN)
                     " %" PRId32 " %" PRId32 " %" PRId32 " %" PRId32
                     CLEAR_COLOR,
                 data->quad[0], data->quad[1],
@@ -1220,17 +1274,17 @@ static void log_data_type(data_type_t type, const GenericData *data)
         break;
 
     case DATA_TYPE_COLOR:
-        fprintf(stderr, COLOR(YELLOW) " #%06" PRIx32 CLEAR_COLOR,
+        fprintf(log_stream, COLOR(YELLOW) " #%06" PRIx32 CLEAR_COLOR,
             data->color);
         break;
 
     case DATA_TYPE_MODIFIERS:
-        fputc(' ', stderr);
+        fputc(' ', log_stream);
         log_modifiers(data->modifiers);
         break;
 
     case DATA_TYPE_CURSOR:
-        fprintf(stderr, " " COLOR(GREEN) "%s" CLEAR_COLOR,
+        fprintf(log_stream, " " COLOR(GREEN) "%s" CLEAR_COLOR,
                 xcursor_core_strings[data->cursor]);
         break;
 
@@ -1245,9 +1299,9 @@ static void log_actions(const Action *actions, uint32_t number_of_actions)
 {
     for (uint32_t i = 0; i < number_of_actions; i++) {
         if (i > 0) {
-            fputs(" ; ", stderr);
+            fputs(" ; ", log_stream);
         }
-        fprintf(stderr, COLOR(CYAN) "%s" CLEAR_COLOR,
+        fprintf(log_stream, COLOR(CYAN) "%s" CLEAR_COLOR,
                 action_to_string(actions[i].code));
         log_data_type(get_action_data_type(actions[i].code), &actions[i].data);
     }
@@ -1256,41 +1310,255 @@ static void log_actions(const Action *actions, uint32_t number_of_actions)
 /* Log the screen information to standard error output. */
 static void log_screen(xcb_screen_t *screen)
 {
-    fprintf(stderr, "Screen(root="); log_hexadecimal(screen->root);
+    fprintf(log_stream, "Screen(root="); log_hexadecimal(screen->root);
     V("default_colormap"); log_hexadecimal(screen->default_colormap);
     V("white_pixel"); log_hexadecimal(screen->white_pixel);
     V("black_pixel"); log_hexadecimal(screen->black_pixel);
     V("size"); log_size(screen->width_in_pixels, screen->height_in_pixels);
     V("millimeter_size"); log_size(screen->width_in_millimeters,
                                 screen->height_in_millimeters);
-    fputs(")", stderr);
+    fputs(")", log_stream);
 }
 
-/* Print a formatted string to standard error output. */
-void log_formatted(log_severity_t severity, const char *file, int line,
-        const char *format, ...)
+/****************/
+/** Log output **/
+
+/* Write all of @data to standard error output, bytes that can not be written
+ * are discarded.
+ */
+static void write_log_output(const char *data, size_t length)
 {
-    va_list list;
-    char buffer[64];
-    time_t current_time;
-    struct tm *tm;
+    ssize_t count;
 
-    /* omit logging if not severe enough */
-    if (log_severity > severity) {
+    while (length > 0) {
+        count = write(STDERR_FILENO, data, length);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        data += count;
+        length -= count;
+    }
+}
+
+/* Drain the log ring to standard error output until the ring is stopped.
+ *
+ * This runs in its own thread.
+ */
+static void *run_log_writer(void *data)
+{
+    struct iovec iov[2];
+    size_t head, tail;
+    size_t start;
+    int count;
+    ssize_t written;
+
+    (void) data;
+
+    tail = log_ring.tail;
+    while (true) {
+        head = __atomic_load_n(&log_ring.head, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            if (__atomic_load_n(&log_ring.is_stopping, __ATOMIC_ACQUIRE)) {
+                break;
+            }
+
+            /* announce that we are sleeping before checking again, the event
+             * loop checks this flag after pushing so either it sees the flag
+             * or we see the pushed bytes
+             */
+            pthread_mutex_lock(&log_ring.mutex);
+            __atomic_store_n(&log_ring.is_sleeping, true, __ATOMIC_SEQ_CST);
+            while (__atomic_load_n(&log_ring.head, __ATOMIC_SEQ_CST) == tail &&
+                    !__atomic_load_n(&log_ring.is_stopping, __ATOMIC_SEQ_CST)) {
+                pthread_cond_wait(&log_ring.condition, &log_ring.mutex);
+            }
+            __atomic_store_n(&log_ring.is_sleeping, false, __ATOMIC_SEQ_CST);
+            pthread_mutex_unlock(&log_ring.mutex);
+            continue;
+        }
+
+        /* write everything pushed so far in one go, the bytes might wrap
+         * around the end of the ring
+         */
+        start = tail % LOG_RING_SIZE;
+        iov[0].iov_base = &log_ring.data[start];
+        if (start + (head - tail) > LOG_RING_SIZE) {
+            iov[0].iov_len = LOG_RING_SIZE - start;
+            iov[1].iov_base = &log_ring.data[0];
+            iov[1].iov_len = head - tail - iov[0].iov_len;
+            count = 2;
+        } else {
+            iov[0].iov_len = head - tail;
+            count = 1;
+        }
+
+        written = writev(STDERR_FILENO, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            /* there is nowhere to put the output, throw it away */
+            written = head - tail;
+        }
+        tail += written;
+        __atomic_store_n(&log_ring.tail, tail, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+/* Start the thread writing the log output. */
+int initialize_logging(void)
+{
+    sigset_t all_signals, old_signals;
+    int error;
+
+    if (log_ring.is_running) {
+        return OK;
+    }
+
+    /* the writer thread must not receive any signals, they are handled by the
+     * event loop
+     */
+    sigfillset(&all_signals);
+    pthread_sigmask(SIG_SETMASK, &all_signals, &old_signals);
+    error = pthread_create(&log_ring.thread, NULL, run_log_writer, NULL);
+    pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+    if (error != 0) {
+        LOG_ERROR("could not create the log writer thread: %s\n",
+                strerror(error));
+        return ERROR;
+    }
+
+    log_ring.is_running = true;
+    return OK;
+}
+
+/* Write out all buffered log output and stop the writer thread. */
+void deinitialize_logging(void)
+{
+    if (!log_ring.is_running) {
         return;
     }
 
-    /* print the time and file with line number at the front */
-    current_time = time(NULL);
-    tm = localtime(&current_time);
-    strftime(buffer, sizeof(buffer),
-            severity == LOG_SEVERITY_ERROR ? COLOR(RED) "{%F %T}" :
-                COLOR(GREEN) "[%F %T]", tm);
-    fprintf(stderr, "%s" COLOR(YELLOW) "(%s:%d) " CLEAR_COLOR,
-            buffer, file, line);
+    pthread_mutex_lock(&log_ring.mutex);
+    __atomic_store_n(&log_ring.is_stopping, true, __ATOMIC_SEQ_CST);
+    pthread_cond_signal(&log_ring.condition);
+    pthread_mutex_unlock(&log_ring.mutex);
+
+    pthread_join(log_ring.thread, NULL);
+
+    log_ring.is_running = false;
+    log_ring.is_stopping = false;
+}
+
+/* Write out the log output still buffered for the writer thread right away. */
+void flush_log_output(void)
+{
+    size_t head, tail;
+    size_t start;
+    size_t part;
+
+    if (!log_ring.is_running) {
+        return;
+    }
+
+    /* the program is about to end, do not wait for the writer thread and
+     * write everything it has not finished directly, further lines are also
+     * written directly
+     */
+    log_ring.is_running = false;
+    head = __atomic_load_n(&log_ring.head, __ATOMIC_ACQUIRE);
+    tail = __atomic_load_n(&log_ring.tail, __ATOMIC_ACQUIRE);
+    start = tail % LOG_RING_SIZE;
+    part = MIN(head - tail, LOG_RING_SIZE - start);
+    write_log_output(&log_ring.data[start], part);
+    write_log_output(&log_ring.data[0], head - tail - part);
+}
+
+/* Push @length bytes to the log ring.
+ *
+ * @return false if there is not enough space.
+ */
+static bool push_log_bytes(const char *bytes, size_t length)
+{
+    size_t head, tail;
+    size_t start;
+    size_t part;
+
+    head = log_ring.head;
+    tail = __atomic_load_n(&log_ring.tail, __ATOMIC_ACQUIRE);
+    if (LOG_RING_SIZE - (head - tail) < length) {
+        return false;
+    }
+
+    start = head % LOG_RING_SIZE;
+    part = MIN(length, LOG_RING_SIZE - start);
+    memcpy(&log_ring.data[start], bytes, part);
+    memcpy(&log_ring.data[0], &bytes[part], length - part);
+
+    __atomic_store_n(&log_ring.head, head + length, __ATOMIC_SEQ_CST);
+    return true;
+}
+
+/* Hand a formatted line to the writer thread or write it directly if there is
+ * no writer thread.
+ */
+static void submit_log_line(const char *line, size_t length)
+{
+    char note[64];
+    int note_length;
+
+    if (!log_ring.is_running) {
+        write_log_output(line, length);
+        return;
+    }
+
+    /* tell about lost lines before the next line that fits */
+    if (log_ring.number_of_dropped_lines > 0) {
+        note_length = snprintf(note, sizeof(note),
+                COLOR(RED) "[%" PRIu32 " lines dropped]\n" CLEAR_COLOR,
+                log_ring.number_of_dropped_lines);
+        if (!push_log_bytes(note, note_length)) {
+            log_ring.number_of_dropped_lines++;
+            return;
+        }
+        log_ring.number_of_dropped_lines = 0;
+    }
+
+    if (!push_log_bytes(line, length)) {
+        log_ring.number_of_dropped_lines++;
+        return;
+    }
+
+    /* wake up the writer if it is waiting for bytes */
+    if (__atomic_load_n(&log_ring.is_sleeping, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&log_ring.mutex);
+        pthread_cond_signal(&log_ring.condition);
+        pthread_mutex_unlock(&log_ring.mutex);
+    }
+}
+
+/* Make sure `log_stream` is open. */
+static void open_log_stream(void)
+{
+    /* format lines into memory so they can be written in one piece */
+    if (log_stream == NULL) {
+        log_stream = open_memstream(&log_line, &log_line_size);
+        if (log_stream == NULL) {
+            log_stream = stderr;
+        }
+    }
+}
+
+/* Print @format with the arguments in @list to `log_stream`. */
+static void log_format_list(const char *format, va_list list)
+{
+    char buffer[64];
 
     /* parse the format string */
-    va_start(list, format);
     for (; format[0] != '\0'; format++) {
         if (format[0] == '%') {
             switch (format[1]) {
@@ -1298,7 +1566,7 @@ void log_formatted(log_severity_t severity, const char *file, int line,
                 format++;
                 /* fall through */
             case '\0':
-                fputc('%', stderr);
+                fputc('%', log_stream);
                 continue;
 
             /* print a point */
@@ -1385,7 +1653,7 @@ void log_formatted(log_severity_t severity, const char *file, int line,
             default: {
                 uint32_t i = 0;
 
-                fputs(COLOR(GREEN), stderr);
+                fputs(COLOR(GREEN), log_stream);
 
                 /* move a segment of `format` into `buffer` and feed it into the
                  * real `printf()`
@@ -1394,8 +1662,8 @@ void log_formatted(log_severity_t severity, const char *file, int line,
                     buffer[i] = format[i];
                     if (strchr(PRINTF_FORMAT_SPECIFIERS, format[i]) != NULL) {
                         buffer[i + 1] = '\0';
-                        vfprintf(stderr, buffer, list);
-                        fputs(CLEAR_COLOR, stderr);
+                        vfprintf(log_stream, buffer, list);
+                        fputs(CLEAR_COLOR, log_stream);
                         format += i - 1;
                         /* all clean */
                         i = 0;
@@ -1406,7 +1674,7 @@ void log_formatted(log_severity_t severity, const char *file, int line,
 
                 /* if anything is weird print the rest of the format string */
                 if (i > 0) {
-                    fputs(format, stderr);
+                    fputs(format, log_stream);
                     while (format[2] != '\0') {
                         format++;
                     }
@@ -1416,8 +1684,89 @@ void log_formatted(log_severity_t severity, const char *file, int line,
             }
             format++;
         } else {
-            fputc(format[0], stderr);
+            fputc(format[0], log_stream);
+        }
+    }
+}
+
+/* Take the line formatted into `log_stream` and rewind the stream.
+ *
+ * @return the length of the line or 0 if the stream is not in memory.
+ */
+static size_t take_log_line(void)
+{
+    long length = 0;
+
+    if (log_stream != stderr) {
+        length = ftell(log_stream);
+        if (fflush(log_stream) != 0 || length < 0) {
+            length = 0;
         }
+        rewind(log_stream);
     }
+    return length;
+}
+
+/* Print a formatted string to standard error output. */
+void log_formatted(log_severity_t severity, const char *file, int line,
+        const char *format, ...)
+{
+    /* the time the time stamp was last formatted */
+    static time_t stamp_time = -1;
+    /* the formatted time stamp */
+    static char stamp[32];
+
+    va_list list;
+    time_t current_time;
+    struct tm *tm;
+    size_t length;
+
+    /* omit logging if not severe enough */
+    if (log_severity > severity) {
+        return;
+    }
+
+    open_log_stream();
+
+    /* only format the time when the second changes */
+    current_time = time(NULL);
+    if (current_time != stamp_time) {
+        tm = localtime(&current_time);
+        strftime(stamp, sizeof(stamp), "%F %T", tm);
+        stamp_time = current_time;
+    }
+
+    /* print the time and file with line number at the front */
+    fprintf(log_stream,
+            severity == LOG_SEVERITY_ERROR ? COLOR(RED) "{%s}" :
+                COLOR(GREEN) "[%s]",
+            stamp);
+    fprintf(log_stream, COLOR(YELLOW) "(%s:%d) " CLEAR_COLOR, file, line);
+
+    va_start(list, format);
+    log_format_list(format, list);
+    va_end(list);
+
+    length = take_log_line();
+    if (length > 0) {
+        submit_log_line(log_line, length);
+    }
+}
+
+/* Print a formatted string to @file without any prefix. */
+void print_formatted(FILE *file, const char *format, ...)
+{
+    va_list list;
+    size_t length;
+
+    open_log_stream();
+
+    va_start(list, format);
+    log_format_list(format, list);
     va_end(list);
+
+    length = take_log_line();
+    if (length > 0) {
+        fwrite(log_line, 1, length, file);
+    }
 }
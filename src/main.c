@@ -3,12 +3,14 @@
 #include "event.h"
 #include "fensterchef.h"
 #include "frame.h"
+#include "ipc.h"
 #include "keymap.h"
 #include "log.h"
 #include "monitor.h"
 #include "program_options.h"
 #include "render.h"
 #include "resources.h"
+#include "trace.h"
 #include "window.h"
 #include "window_properties.h"
 #include "x11_management.h"
@@ -40,6 +42,13 @@ int main(int argc, char **argv)
         exit(EXIT_FAILURE);
     }
 
+    /* write the log output from a separate thread, if this fails, the output
+     * is written directly
+     */
+    if (log_severity != LOG_SEVERITY_NOTHING) {
+        (void) initialize_logging();
+    }
+
     LOG("parsed arguments, starting to log\n");
     LOG("welcome to " FENSTERCHEF_NAME " " FENSTERCHEF_VERSION "\n");
     LOG("the configuration file may reside in %s\n", Fensterchef_configuration);
@@ -78,6 +87,9 @@ int main(int argc, char **argv)
     /* initialize randr if possible and the initial frames */
     initialize_monitors();
 
+    /* start writing the trace if requested, this needs the atoms and randr */
+    (void) initialize_trace();
+
     /* set the X properties on the root window */
     initialize_root_properties();
 
@@ -87,6 +99,11 @@ int main(int argc, char **argv)
     load_default_configuration();
     reload_user_configuration();
 
+    /* open the socket for external commands, fensterchef also works without
+     * it
+     */
+    (void) initialize_ipc();
+
     /* manage the windows that are already there */
     query_existing_windows();
 
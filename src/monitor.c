@@ -6,6 +6,8 @@
 #include "configuration.h"
 #include "event.h" // randr_event_base
 #include "frame.h"
+#include "ipc.h"
+#include "latency.h"
 #include "log.h"
 #include "monitor.h"
 #include "render.h"
@@ -23,6 +25,9 @@ static bool randr_enabled = false;
 /* the first monitor in the monitor linked list */
 Monitor *Monitor_first;
 
+/* if the monitor struts need to be recomputed */
+bool are_monitors_dirty;
+
 /* Create a screenless monitor. */
 static Monitor *create_monitor(const char *name, uint32_t name_len)
 {
@@ -52,7 +57,8 @@ void initialize_monitors(void)
     /* get the randr version number, currently not used for anything */
     version_cookie = xcb_randr_query_version(connection,
             XCB_RANDR_MAJOR_VERSION, XCB_RANDR_MINOR_VERSION);
-    version = xcb_randr_query_version_reply(connection, version_cookie, &error);
+    version = ROUND_TRIP(xcb_randr_query_version_reply(connection,
+                version_cookie, &error));
     if (version == NULL) {
         LOG_ERROR("could not query randr version: %E\n", error);
         free(error);
@@ -141,6 +147,8 @@ static void push_other_dock_windows(Monitor *monitor, Window *window)
         default:
             break;
         }
+
+        mark_window_dirty(other);
     }
 }
 
@@ -647,8 +655,8 @@ Monitor *query_monitors(void)
             screen->root);
 
     /* get the primary monitor */
-    primary = xcb_randr_get_output_primary_reply(connection, primary_cookie,
-            NULL);
+    primary = ROUND_TRIP(xcb_randr_get_output_primary_reply(connection,
+                primary_cookie, NULL));
     if (primary == NULL) {
         primary_output = XCB_NONE;
     } else {
@@ -657,8 +665,8 @@ Monitor *query_monitors(void)
     }
 
     /* get the screen resources for querying the screen outputs */
-    resources = xcb_randr_get_screen_resources_current_reply(connection,
-            resources_cookie, &error);
+    resources = ROUND_TRIP(xcb_randr_get_screen_resources_current_reply(
+                connection, resources_cookie, &error));
     if (error != NULL) {
         LOG_ERROR("could not get screen resources: %E\n", error);
         free(error);
@@ -674,8 +682,8 @@ Monitor *query_monitors(void)
         /* get the output information which includes the output name */
         output_cookie = xcb_randr_get_output_info(connection, outputs[i],
                resources->timestamp);
-        output = xcb_randr_get_output_info_reply(connection, output_cookie,
-                &error);
+        output = ROUND_TRIP(xcb_randr_get_output_info_reply(connection,
+                    output_cookie, &error));
         if (error != NULL) {
             LOG_ERROR("unable to get output info of %d: %E\n", i, error);
             free(error);
@@ -698,7 +706,8 @@ Monitor *query_monitors(void)
         crtc_cookie = xcb_randr_get_crtc_info(connection, output->crtc,
                 resources->timestamp);
 
-        crtc = xcb_randr_get_crtc_info_reply(connection, crtc_cookie, &error);
+        crtc = ROUND_TRIP(xcb_randr_get_crtc_info_reply(connection,
+                    crtc_cookie, &error));
         if (crtc == NULL) {
             LOG_ERROR("output %.*s gave a NULL crtc: %E\n", name_length, name,
                     error);
@@ -796,6 +805,7 @@ Monitor *query_monitors(void)
 void merge_monitors(Monitor *monitors)
 {
     Frame *focus_frame_root;
+    uint32_t count = 0;
 
     if (monitors == NULL) {
         monitors = create_monitor("default", UINT32_MAX);
@@ -837,6 +847,8 @@ void merge_monitors(Monitor *monitors)
 
     Monitor_first = monitors;
 
+    are_monitors_dirty = true;
+
     /* initialize the remaining monitors' frames */
     for (Monitor *monitor = monitors; monitor != NULL;
             monitor = monitor->next) {
@@ -862,4 +874,10 @@ void merge_monitors(Monitor *monitors)
     if (Frame_focus == NULL) {
         set_focus_frame(Monitor_first->frame);
     }
+
+    for (Monitor *monitor = monitors; monitor != NULL;
+            monitor = monitor->next) {
+        count++;
+    }
+    publish_ipc_event(IPC_EVENT_MONITORS, "%" PRIu32, count);
 }
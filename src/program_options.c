@@ -2,6 +2,7 @@
 
 #include "fensterchef.h"
 #include "program_options.h"
+#include "trace.h"
 
 /* how fensterchef is started */
 static const char *program_name;
@@ -15,6 +16,8 @@ typedef enum option {
     OPTION_VERBOSE, /* --verbose */
     OPTION_CONFIG, /* --config FILE */
     OPTION_COMMAND, /* -e, --command COMMAND */
+    OPTION_TRACE, /* --trace FILE */
+    OPTION_DECODE_TRACE, /* --decode-trace FILE */
 } option_t;
 
 /* context the parser needs to parse the options */
@@ -35,6 +38,8 @@ static const struct parse_option {
     [OPTION_VERBOSE] = { "verbose", '\0', 0 },
     [OPTION_CONFIG] = { "config", '\0', 1 },
     [OPTION_COMMAND] = { "command", 'e', 1 },
+    [OPTION_TRACE] = { "trace", '\0', 1 },
+    [OPTION_DECODE_TRACE] = { "decode-trace", '\0', 1 },
 };
 
 /* Print the usage to standard error output. */
@@ -51,7 +56,9 @@ static void print_usage(void)
             nothing                 log nothing\n\
         --verbose                   log everything\n\
         --config        FILE        set the path of the configuration\n\
-        -e, --command   COMMAND     run a command within fensterchef\n",
+        -e, --command   COMMAND     run a command within fensterchef\n\
+        --trace         FILE        write a binary trace of events to FILE\n\
+        --decode-trace  FILE        print the trace within FILE\n",
         stderr);
 
 }
@@ -118,6 +125,17 @@ static int handle_option(option_t option, char *value)
     case OPTION_COMMAND:
         run_external_command(value);
         return ERROR;
+
+    /* write a trace */
+    case OPTION_TRACE:
+        free(trace_path);
+        trace_path = xstrdup(value);
+        return OK;
+
+    /* print a trace */
+    case OPTION_DECODE_TRACE:
+        (void) decode_trace(value);
+        return ERROR;
     }
 
     print_usage();
@@ -1,6 +1,7 @@
 #include <inttypes.h>
 
 #include "configuration.h"
+#include "latency.h"
 #include "log.h"
 #include "render.h"
 #include "utility.h"
@@ -18,6 +19,9 @@ struct xrender_version Render_version;
 /* the render formats for pictures */
 static xcb_render_query_pict_formats_reply_t *picture_formats;
 
+/* graphics context used for filling and copying back buffers */
+static xcb_gcontext_t back_buffer_gc;
+
 /* Get the format of a visual. */
 xcb_render_pictformat_t find_visual_format(xcb_visualid_t visual)
 {
@@ -78,8 +82,8 @@ int initialize_renderer(void)
                 XCB_RENDER_MAJOR_VERSION, XCB_RENDER_MINOR_VERSION);
         formats_cookie = xcb_render_query_pict_formats(connection);
 
-        version = xcb_render_query_version_reply(connection, version_cookie,
-                NULL);
+        version = ROUND_TRIP(xcb_render_query_version_reply(connection,
+                    version_cookie, NULL));
         if (version != NULL) {
             Render_version.major = version->major_version;
             Render_version.minor = version->minor_version;
@@ -89,10 +93,18 @@ int initialize_renderer(void)
         /* the picture formats are the possible ways colors can be represented,
          * for example ARGB, 8 bit colors etc.
          */
-        picture_formats = xcb_render_query_pict_formats_reply(connection,
-                formats_cookie, NULL);
+        picture_formats = ROUND_TRIP(xcb_render_query_pict_formats_reply(
+                    connection, formats_cookie, NULL));
     }
 
+    /* create the graphics context for the back buffers, the exposure events
+     * are not needed since the back buffer is always fully available
+     */
+    back_buffer_gc = xcb_generate_id(connection);
+    general_values[0] = false;
+    xcb_create_gc(connection, back_buffer_gc, screen->root,
+            XCB_GC_GRAPHICS_EXPOSURES, general_values);
+
     /* initialize both font drawing systems */
     initialize_legacy_font_drawing();
     initialize_modern_font_drawing();
@@ -106,6 +118,57 @@ int initialize_renderer(void)
     return OK;
 }
 
+/* Make sure @buffer can hold at least @width times @height pixels. */
+bool resize_back_buffer(BackBuffer *buffer, uint32_t width, uint32_t height)
+{
+    if (buffer->pixmap != XCB_NONE && width <= buffer->width &&
+            height <= buffer->height) {
+        return false;
+    }
+
+    free_back_buffer(buffer);
+
+    buffer->width = MAX(width, buffer->width);
+    buffer->height = MAX(height, buffer->height);
+    buffer->pixmap = xcb_generate_id(connection);
+    xcb_create_pixmap(connection, screen->root_depth, buffer->pixmap,
+            buffer->window, buffer->width, buffer->height);
+    return true;
+}
+
+/* Fill @rectangle within the back buffer with a solid color. */
+void fill_back_buffer(BackBuffer *buffer, const xcb_rectangle_t *rectangle,
+        uint32_t color)
+{
+    general_values[0] = color;
+    xcb_change_gc(connection, back_buffer_gc, XCB_GC_FOREGROUND,
+            general_values);
+    xcb_poly_fill_rectangle(connection, buffer->pixmap, back_buffer_gc, 1,
+            rectangle);
+}
+
+/* Copy @rectangle of the back buffer onto the same region of its window. */
+void present_back_buffer(BackBuffer *buffer, const xcb_rectangle_t *rectangle)
+{
+    if (buffer->pixmap == XCB_NONE) {
+        return;
+    }
+    xcb_copy_area(connection, buffer->pixmap, buffer->window, back_buffer_gc,
+            rectangle->x, rectangle->y, rectangle->x, rectangle->y,
+            rectangle->width, rectangle->height);
+}
+
+/* Free the pixmap of the back buffer. */
+void free_back_buffer(BackBuffer *buffer)
+{
+    if (buffer->pixmap == XCB_NONE) {
+        return;
+    }
+    release_drawable_picture(buffer->pixmap);
+    xcb_free_pixmap(connection, buffer->pixmap);
+    buffer->pixmap = XCB_NONE;
+}
+
 /* Measure a text that has no new lines. */
 void measure_text(const utf8_t *utf8, uint32_t length,
         struct text_measure *measure)
@@ -1,3 +1,4 @@
+#include "latency.h"
 #include "render.h"
 #include "x11_management.h"
 
@@ -92,8 +93,8 @@ void draw_text_legacy(xcb_drawable_t drawable, const utf8_t *utf8,
 
     for (uint32_t i = 0, j = 0; i <= segments; i++) {
         if (i > 0) {
-            extents = xcb_query_text_extents_reply(connection,
-                    extents_cookies[i], NULL);
+            extents = ROUND_TRIP(xcb_query_text_extents_reply(connection,
+                    extents_cookies[i], NULL));
             if (extents != NULL) {
                 x += extents->overall_width;
                 free(extents);
@@ -119,8 +120,8 @@ void measure_text_legacy(const utf8_t *utf8, uint32_t length,
             length, ucs);
     free(ucs);
 
-    extents = xcb_query_text_extents_reply(connection, extents_cookie,
-            NULL);
+    extents = ROUND_TRIP(xcb_query_text_extents_reply(connection,
+                extents_cookie, NULL));
     if (extents != NULL) {
         measure->ascent = extents->overall_ascent;
         measure->descent = extents->overall_descent;
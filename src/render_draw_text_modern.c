@@ -1,11 +1,81 @@
+#include <errno.h>
+#include <fcntl.h>
 #include <inttypes.h>
-
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "configuration.h"
+#include "fensterchef.h"
 #include "log.h"
 #include "render.h"
 #include "resources.h"
 #include "x11_management.h"
 #include "xalloc.h"
 
+/* the minimum number of slots in the glyph metrics map */
+#define GLYPH_MAP_MINIMUM_CAPACITY 256
+
+/* the number of code points that form a block within the fallback face index */
+#define GLYPH_BLOCK_SIZE 256
+
+/* the number of blocks needed to cover all unicode code points */
+#define GLYPH_BLOCK_COUNT (0x110000 / GLYPH_BLOCK_SIZE)
+
+/* the maximum number of bytes sent in one request to upload glyphs, the core
+ * protocol allows up to 256 KiB without the big requests extension
+ */
+#define GLYPH_UPLOAD_MAXIMUM_SIZE 65536
+
+/* the magic bytes at the start of a glyph cache file, the last character is
+ * the version of the file format
+ */
+#define GLYPH_CACHE_MAGIC "fcglyph1"
+
+/* the header of a glyph cache file
+ *
+ * A glyph cache file stores glyphs that were rendered before so they can be
+ * uploaded again without touching freetype. The header is followed by the key
+ * identifying the font and then by any number of glyph records.
+ */
+struct glyph_cache_header {
+    /* `GLYPH_CACHE_MAGIC` without the null terminator */
+    char magic[8];
+    /* the length of the key following the header, the key is padded with null
+     * bytes to a multiple of 4
+     */
+    uint32_t key_length;
+};
+
+/* a glyph within the glyph cache file, it is followed by the bitmap of the
+ * glyph with each row padded to a multiple of 4
+ */
+struct glyph_cache_record {
+    /* the unicode code point of the glyph */
+    uint32_t glyph;
+    /* the glyph information passed to the X server */
+    xcb_render_glyphinfo_t info;
+    /* the metrics of the glyph, see `struct glyph_metrics` */
+    int32_t advance;
+    int32_t ascent;
+    int32_t descent;
+};
+
+/* metrics of a glyph that was added to the glyphset */
+struct glyph_metrics {
+    /* the unicode code point of the glyph, 0 marks an empty slot */
+    uint32_t glyph;
+    /* false if no face has the glyph and it can not be rendered */
+    bool is_renderable;
+    /* how far to move the pen after drawing the glyph in pixels */
+    int32_t advance;
+    /* the ascender and descender of the face in pixels */
+    int32_t ascent;
+    int32_t descent;
+};
+
 /* the font used for rendering */
 static struct font {
     /* if font drawing was initialized */
@@ -20,21 +90,90 @@ static struct font {
     FT_Face *faces;
     /* number of freetype font faces */
     uint32_t number_of_faces;
+    /* the number of faces the user specified, the faces after them are
+     * fallback faces that were loaded because the user's faces miss glyphs
+     */
+    uint32_t number_of_primary_faces;
+    /* for each block of code points, the index + 1 of the fallback face that
+     * last had a glyph of that block, this is checked before all other
+     * fallback faces
+     */
+    uint16_t *block_faces;
     /* the xcb glyphset containing glyphs */
     xcb_render_glyphset_t glyphset;
-    /* we use this to remember which glyphs we added to the glyphset */
-    FcCharSet *charset;
+    /* the glyph cache file newly rendered glyphs are appended to or -1 */
+    int cache_file;
+    /* The metrics of all glyphs we added to the glyphset so that drawing or
+     * measuring a glyph a second time does not need to go through freetype.
+     *
+     * This is a hash map using open addressing with linear probing. The
+     * capacity is always a power of two and at most half of the slots are in
+     * use.
+     */
+    struct glyph_metrics *glyphs;
+    /* the number of slots in `glyphs` */
+    uint32_t glyph_capacity;
+    /* the number of used slots in `glyphs` */
+    uint32_t number_of_glyphs;
+    /* the number of bits to shift the hash to the right so that it fits into
+     * the capacity
+     */
+    uint32_t glyph_shift;
 } font;
 
-/* a mapping from drawable to picture */
-static struct drawable_picture_cache {
+/* glyphs waiting to be uploaded to the glyphset, they are collected while
+ * measuring or drawing a text and then uploaded in a single request
+ *
+ * The memory is kept around so it can be reused by the next upload.
+ */
+static struct glyph_upload {
+    /* the code points of the glyphs */
+    uint32_t *glyphs;
+    /* the glyph information of each glyph */
+    xcb_render_glyphinfo_t *infos;
+    /* the number of glyphs waiting to be uploaded */
+    uint32_t number_of_glyphs;
+    /* the number of glyphs `glyphs` and `infos` can hold */
+    uint32_t glyph_capacity;
+    /* the bitmaps of all glyphs one after another */
+    uint8_t *data;
+    /* the number of bytes used in `data` */
+    uint32_t data_size;
+    /* the number of bytes `data` can hold */
+    uint32_t data_capacity;
+} glyph_upload;
+
+/* the number of slots in the drawable picture map, this must be a power of two
+ */
+#define DRAWABLE_PICTURE_CAPACITY 64
+
+/* the number of bits needed to index a slot of the drawable picture map */
+#define DRAWABLE_PICTURE_BITS 6
+
+/* the maximum number of pictures kept at once, when more are needed, the least
+ * recently used one is freed
+ */
+#define DRAWABLE_PICTURE_MAXIMUM (DRAWABLE_PICTURE_CAPACITY / 2)
+
+/* a mapping from drawable to picture
+ *
+ * This is a hash map using open addressing with linear probing, a drawable of
+ * `XCB_NONE` marks an empty slot.
+ */
+static struct drawable_picture {
     /* the id of the drawable */
     xcb_drawable_t drawable;
     /* the picture created for the drawable */
     xcb_render_picture_t picture;
-    /* the next cache object in the linked list */
-    struct drawable_picture_cache *next;
-} *drawable_picture_cache_head;
+    /* the value of `drawable_picture_clock` when the picture was last used */
+    uint32_t last_use;
+} drawable_pictures[DRAWABLE_PICTURE_CAPACITY];
+
+/* the number of used slots in `drawable_pictures` */
+static uint32_t number_of_drawable_pictures;
+
+/* counter incremented on every picture use */
+static uint32_t drawable_picture_clock;
 
 /* Check if modern fonts are initialized. */
 inline bool has_modern_font_drawing(void)
@@ -42,49 +181,115 @@ inline bool has_modern_font_drawing(void)
     return font.is_available;
 }
 
-/* Create a picture for the given window (or retrieve it from the cache).
+/* Find the slot of @drawable within the drawable picture map.
  *
- * The cached items do not need to be cleared ever since they are only for the
- * two fensterchef windows (notification and window list) which only get cleared
- * when fensterchef quits.
+ * @return the slot holding @drawable or the empty slot it would go into.
+ */
+static struct drawable_picture *find_drawable_picture_slot(
+        xcb_drawable_t drawable)
+{
+    uint32_t index;
+
+    index = (uint32_t) (drawable * UINT32_C(2654435769)) >>
+        (32 - DRAWABLE_PICTURE_BITS);
+    while (drawable_pictures[index].drawable != XCB_NONE &&
+            drawable_pictures[index].drawable != drawable) {
+        index = (index + 1) & (DRAWABLE_PICTURE_CAPACITY - 1);
+    }
+    return &drawable_pictures[index];
+}
+
+/* Free the picture in @slot and remove it from the drawable picture map. */
+static void remove_drawable_picture(struct drawable_picture *slot)
+{
+    uint32_t index, next;
+    struct drawable_picture *entry;
+    struct drawable_picture moved;
+
+    xcb_render_free_picture(connection, slot->picture);
+    slot->drawable = XCB_NONE;
+    number_of_drawable_pictures--;
+
+    /* move following entries back so that no gap is within their probe
+     * sequence
+     */
+    index = slot - drawable_pictures;
+    next = (index + 1) & (DRAWABLE_PICTURE_CAPACITY - 1);
+    while (drawable_pictures[next].drawable != XCB_NONE) {
+        entry = &drawable_pictures[next];
+        /* take the entry out and put it back in */
+        moved = *entry;
+        entry->drawable = XCB_NONE;
+        *find_drawable_picture_slot(moved.drawable) = moved;
+        next = (next + 1) & (DRAWABLE_PICTURE_CAPACITY - 1);
+    }
+}
+
+/* Create a picture for the given drawable (or retrieve it from the cache).
+ *
+ * Only `DRAWABLE_PICTURE_MAXIMUM` pictures are kept, pictures of drawables
+ * that are freed should be released through `release_drawable_picture()`.
  */
 static xcb_render_picture_t cache_drawable_picture(xcb_drawable_t drawable)
 {
-    struct drawable_picture_cache *last;
-    struct drawable_picture_cache *cache;
-    xcb_render_picture_t picture;
+    struct drawable_picture *slot;
+    struct drawable_picture *oldest;
 
-    if (drawable_picture_cache_head == NULL) {
-        cache = xmalloc(sizeof(*cache));
-        drawable_picture_cache_head = cache;
-        last = NULL;
-    } else {
-        for (last = drawable_picture_cache_head; true; last = last->next) {
-            if (last->drawable == drawable) {
-                return last->picture;
+    drawable_picture_clock++;
+
+    slot = find_drawable_picture_slot(drawable);
+    if (slot->drawable == drawable) {
+        slot->last_use = drawable_picture_clock;
+        return slot->picture;
+    }
+
+    /* evict the least recently used picture if the map is full */
+    if (number_of_drawable_pictures == DRAWABLE_PICTURE_MAXIMUM) {
+        oldest = NULL;
+        for (uint32_t i = 0; i < DRAWABLE_PICTURE_CAPACITY; i++) {
+            if (drawable_pictures[i].drawable == XCB_NONE) {
+                continue;
             }
-            if (last->next == NULL) {
-                break;
+            if (oldest == NULL || drawable_picture_clock -
+                        drawable_pictures[i].last_use >
+                    drawable_picture_clock - oldest->last_use) {
+                oldest = &drawable_pictures[i];
             }
         }
-        cache = xmalloc(sizeof(*drawable_picture_cache_head));
-        last->next = cache;
+        LOG_VERBOSE("evicting picture of drawable %#" PRIx32 "\n",
+                oldest->drawable);
+        remove_drawable_picture(oldest);
+        slot = find_drawable_picture_slot(drawable);
     }
 
-    cache->drawable = drawable;
-    cache->next = NULL;
-
     /* create a picture for rendering */
-    picture = xcb_generate_id(connection);
+    slot->drawable = drawable;
+    slot->picture = xcb_generate_id(connection);
+    slot->last_use = drawable_picture_clock;
+    number_of_drawable_pictures++;
+
     general_values[0] = XCB_RENDER_POLY_MODE_IMPRECISE;
     general_values[1] = XCB_RENDER_POLY_EDGE_SMOOTH;
-    xcb_render_create_picture(connection, picture, drawable,
+    xcb_render_create_picture(connection, slot->picture, drawable,
                 find_visual_format(screen->root_visual),
                 XCB_RENDER_CP_POLY_MODE | XCB_RENDER_CP_POLY_EDGE,
                 general_values);
+    return slot->picture;
+}
 
-    cache->picture = picture;
-    return picture;
+/* Release the picture that was created for drawing onto @drawable. */
+void release_drawable_picture(xcb_drawable_t drawable)
+{
+    struct drawable_picture *slot;
+
+    if (drawable == XCB_NONE) {
+        return;
+    }
+
+    slot = find_drawable_picture_slot(drawable);
+    if (slot->drawable == drawable) {
+        remove_drawable_picture(slot);
+    }
 }
 
 /* Set the color of a pen. */
@@ -141,6 +346,8 @@ int initialize_modern_font_drawing(void)
 
     font.pen = create_pen();
 
+    font.cache_file = -1;
+
     /* create the glyphset which will store the glyph pixel data */
     font.glyphset = xcb_generate_id(connection);
     xcb_render_create_glyph_set(connection, font.glyphset,
@@ -161,7 +368,6 @@ static FT_Face create_font_face(FcPattern *pattern)
     /* get the file name of the font */
     if (FcPatternGet(pattern, FC_FILE, 0, &fc_file) != FcResultMatch) {
         LOG_ERROR("could not not get the font file\n");
-        FcPatternDestroy(pattern);
         return NULL;
     }
 
@@ -176,7 +382,6 @@ static FT_Face create_font_face(FcPattern *pattern)
             fc_index.u.i, &face);
     if (ft_error != FT_Err_Ok) {
         LOG_ERROR("could not not create the new freetype face: %d", ft_error);
-        FcPatternDestroy(pattern);
         return NULL;
     }
 
@@ -231,12 +436,26 @@ static void free_font(void)
     free(font.faces);
     font.faces = NULL;
     font.number_of_faces = 0;
-    FcCharSetDestroy(font.charset);
+    font.number_of_primary_faces = 0;
+    free(font.block_faces);
+    font.block_faces = NULL;
+    free(font.glyphs);
+    font.glyphs = NULL;
+    font.glyph_capacity = 0;
+    font.number_of_glyphs = 0;
+    if (font.cache_file >= 0) {
+        close(font.cache_file);
+        font.cache_file = -1;
+    }
 }
 
+/* Load the glyph cache file of the current font and open it for appending. */
+static void open_glyph_cache(const utf8_t *query);
+
 /* This sets the globally used font for rendering. */
 int set_modern_font(const utf8_t *query)
 {
+    const utf8_t *const full_query = query;
     int error = OK;
     FT_Face *faces;
     uint32_t number_of_faces;
@@ -326,110 +545,530 @@ int set_modern_font(const utf8_t *query)
 
     font.faces = faces;
     font.number_of_faces = number_of_faces;
-    font.charset = FcCharSetCreate();
+    font.number_of_primary_faces = number_of_faces;
     font.is_available = true;
+
+    if (configuration.font.cache_glyphs) {
+        open_glyph_cache(full_query);
+    }
     return OK;
 }
 
 /* Attempts to find a font containing given glyph. */
 static FT_Face create_font_face_containing_glyph(uint32_t glyph)
 {
-	FcBool status;
-	FcResult result;
-	FcCharSet *charset;
-	FcPattern *finding_pattern, *pattern;
-	FT_Face face;
-
-	/* create the pattern and font face to hold onto the glyph */
-	charset = FcCharSetCreate();
-	FcCharSetAddChar(charset, glyph);
-	finding_pattern = FcPatternCreate();
-	FcPatternAddCharSet(finding_pattern, FC_CHARSET, charset);
+    FcBool status;
+    FcResult result;
+    FcCharSet *charset;
+    FcPattern *finding_pattern, *pattern;
+    FT_Face face;
+
+    /* create the pattern and font face to hold onto the glyph */
+    charset = FcCharSetCreate();
+    FcCharSetAddChar(charset, glyph);
+    finding_pattern = FcPatternCreate();
+    FcPatternAddCharSet(finding_pattern, FC_CHARSET, charset);
+    FcCharSetDestroy(charset);
 
     /* uses the current configuration to fill the finding pattern */
-	status = FcConfigSubstitute(NULL, finding_pattern, FcMatchPattern);
-	if (status == FcFalse) {
-		FcCharSetDestroy(charset);
-		return NULL;
-	}
+    status = FcConfigSubstitute(NULL, finding_pattern, FcMatchPattern);
+    if (status == FcFalse) {
+        FcPatternDestroy(finding_pattern);
+        return NULL;
+    }
     /* this supplies the pattern with some default values if some are unset */
-	FcDefaultSubstitute(finding_pattern);
+    FcDefaultSubstitute(finding_pattern);
 
     /* gets the font that matches best with what is requested */
-	pattern = FcFontMatch(NULL, finding_pattern, &result);
+    pattern = FcFontMatch(NULL, finding_pattern, &result);
 
-	FcPatternDestroy(finding_pattern);
+    FcPatternDestroy(finding_pattern);
 
-	if (result != FcResultMatch) {
-		FcCharSetDestroy(charset);
-		return NULL;
-	}
+    if (result != FcResultMatch) {
+        return NULL;
+    }
+
+    /* the best match does not necessarily have the glyph, do not bother
+     * creating a face in that case
+     */
+    if (FcPatternGetCharSet(pattern, FC_CHARSET, 0, &charset) !=
+                FcResultMatch ||
+            !FcCharSetHasChar(charset, glyph)) {
+        FcPatternDestroy(pattern);
+        return NULL;
+    }
+
+    face = create_font_face(pattern);
 
-	face = create_font_face(pattern);
+    FcPatternDestroy(pattern);
 
-	FcCharSetDestroy(charset);
+    return face;
+}
+
+/* Load @glyph from @face if the face has it.
+ *
+ * @return false if the face does not have the glyph.
+ */
+static inline bool load_glyph_from_face(FT_Face face, uint32_t glyph,
+        FT_Int32 load_flags)
+{
+    FT_UInt glyph_index;
 
-	return face;
+    glyph_index = FT_Get_Char_Index(face, glyph);
+    if (glyph_index == 0) {
+        return false;
+    }
+    return FT_Load_Glyph(face, glyph_index, load_flags) == FT_Err_Ok;
 }
 
 /* Load a glyph into a face and return the face it was loaded in. */
 static FT_Face load_glyph(uint32_t glyph, FT_Int32 load_flags)
 {
-    FT_UInt glyph_index;
+    const uint32_t block = glyph / GLYPH_BLOCK_SIZE;
+    uint32_t hint = 0;
     FT_Face face;
 
+    /* the faces the user specified take precedence */
+    for (uint32_t i = 0; i < font.number_of_primary_faces; i++) {
+        if (load_glyph_from_face(font.faces[i], glyph, load_flags)) {
+            return font.faces[i];
+        }
+    }
+
+    /* try the fallback face that had the last glyph of the same block */
+    if (font.block_faces != NULL && block < GLYPH_BLOCK_COUNT) {
+        hint = font.block_faces[block];
+        if (hint > 0 && load_glyph_from_face(font.faces[hint - 1], glyph,
+                    load_flags)) {
+            return font.faces[hint - 1];
+        }
+    }
+
+    /* try all other fallback faces */
     face = NULL;
-    for (uint32_t j = 0; j < font.number_of_faces; j++) {
-        glyph_index = FT_Get_Char_Index(font.faces[j], glyph);
-        if (glyph_index == 0) {
+    for (uint32_t i = font.number_of_primary_faces;
+            i < font.number_of_faces; i++) {
+        if (i + 1 == hint) {
             continue;
         }
-        if (FT_Load_Glyph(font.faces[j], glyph_index, load_flags) != FT_Err_Ok) {
-            return NULL;
+        if (load_glyph_from_face(font.faces[i], glyph, load_flags)) {
+            face = font.faces[i];
+            hint = i + 1;
+            break;
         }
-        face = font.faces[j];
-        return face;
     }
 
     /* glyph was not found, try an alternative font face */
-    face = create_font_face_containing_glyph(glyph);
     if (face == NULL) {
-        return NULL;
-    }
+        face = create_font_face_containing_glyph(glyph);
+        if (face == NULL) {
+            return NULL;
+        }
 
-    /* add the face to the font face list */
-    RESIZE(font.faces, font.number_of_faces + 1);
-    font.faces[font.number_of_faces++] = face;
+        /* add the face to the font face list */
+        RESIZE(font.faces, font.number_of_faces + 1);
+        font.faces[font.number_of_faces++] = face;
+        hint = font.number_of_faces;
 
-    glyph_index = FT_Get_Char_Index(face, glyph);
-    if (glyph_index == 0) {
-        return NULL;
+        if (!load_glyph_from_face(face, glyph, load_flags)) {
+            return NULL;
+        }
     }
-    if (FT_Load_Glyph(face, glyph_index, load_flags) != FT_Err_Ok) {
-        return NULL;
+
+    /* remember the face for the block of the glyph */
+    if (block < GLYPH_BLOCK_COUNT && hint <= UINT16_MAX) {
+        if (font.block_faces == NULL) {
+            font.block_faces = xcalloc(GLYPH_BLOCK_COUNT,
+                    sizeof(*font.block_faces));
+        }
+        font.block_faces[block] = hint;
     }
     return face;
 }
 
-/* Add the glyph to the cache if not already cached. */
-static FT_Face cache_glyph(uint32_t glyph)
+/* Get the slot index the metrics of @glyph ideally have. */
+static inline uint32_t get_glyph_map_hash(uint32_t glyph)
+{
+    /* Fibonacci hashing, glyphs of a text are mostly within a small range
+     * which this spreads out well
+     */
+    return (uint32_t) (glyph * UINT32_C(2654435769)) >> font.glyph_shift;
+}
+
+/* Find the slot of @glyph within the glyph map.
+ *
+ * @return the slot holding @glyph or the empty slot it would go into.
+ */
+static struct glyph_metrics *find_glyph_slot(uint32_t glyph)
+{
+    uint32_t index;
+
+    index = get_glyph_map_hash(glyph);
+    while (font.glyphs[index].glyph != 0 && font.glyphs[index].glyph != glyph) {
+        index = (index + 1) & (font.glyph_capacity - 1);
+    }
+    return &font.glyphs[index];
+}
+
+/* Double the capacity of the glyph map and rehash all glyphs. */
+static void grow_glyph_map(void)
+{
+    struct glyph_metrics *old_glyphs;
+    uint32_t old_capacity;
+
+    old_glyphs = font.glyphs;
+    old_capacity = font.glyph_capacity;
+
+    if (font.glyph_capacity == 0) {
+        font.glyph_capacity = GLYPH_MAP_MINIMUM_CAPACITY;
+        font.glyph_shift = 32;
+        for (uint32_t i = font.glyph_capacity; i > 1; i >>= 1) {
+            font.glyph_shift--;
+        }
+    } else {
+        font.glyph_capacity *= 2;
+        font.glyph_shift--;
+    }
+    font.glyphs = xcalloc(font.glyph_capacity, sizeof(*font.glyphs));
+
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        if (old_glyphs[i].glyph != 0) {
+            *find_glyph_slot(old_glyphs[i].glyph) = old_glyphs[i];
+        }
+    }
+    free(old_glyphs);
+}
+
+/* Add a slot for @glyph to the glyph map, @glyph must not be in the map yet.
+ *
+ * @return the slot with only the glyph set.
+ */
+static struct glyph_metrics *add_glyph_metrics(uint32_t glyph)
+{
+    struct glyph_metrics *metrics;
+
+    /* keep the load factor at or below 1/2 */
+    if ((font.number_of_glyphs + 1) * 2 > font.glyph_capacity) {
+        grow_glyph_map();
+    }
+    metrics = find_glyph_slot(glyph);
+    metrics->glyph = glyph;
+    font.number_of_glyphs++;
+    return metrics;
+}
+
+/* Upload all glyphs waiting in `glyph_upload` with a single request. */
+static void flush_glyph_upload(void)
 {
+    if (glyph_upload.number_of_glyphs == 0) {
+        return;
+    }
+
+    xcb_render_add_glyphs(connection, font.glyphset,
+            glyph_upload.number_of_glyphs, glyph_upload.glyphs,
+            glyph_upload.infos, glyph_upload.data_size, glyph_upload.data);
+
+    LOG_VERBOSE("uploaded %" PRIu32 " glyphs (%" PRIu32 " bytes)\n",
+            glyph_upload.number_of_glyphs, glyph_upload.data_size);
+
+    glyph_upload.number_of_glyphs = 0;
+    glyph_upload.data_size = 0;
+}
+
+/* Add a glyph to the glyphs waiting to be uploaded.
+ *
+ * @size is the size of the bitmap with a stride of the width rounded up to a
+ *       multiple of 4.
+ *
+ * @return the zeroed memory the bitmap should be written to, it is only valid
+ *         until the next call.
+ */
+static uint8_t *queue_glyph_upload(uint32_t glyph,
+        const xcb_render_glyphinfo_t *info, uint32_t size)
+{
+    uint8_t *bitmap;
+
+    /* each glyph also needs its code point and glyph information within the
+     * request
+     */
+    if ((glyph_upload.number_of_glyphs + 1) *
+                (sizeof(*glyph_upload.glyphs) + sizeof(*glyph_upload.infos)) +
+            glyph_upload.data_size + size > GLYPH_UPLOAD_MAXIMUM_SIZE) {
+        flush_glyph_upload();
+    }
+
+    if (glyph_upload.number_of_glyphs == glyph_upload.glyph_capacity) {
+        glyph_upload.glyph_capacity = MAX(glyph_upload.glyph_capacity * 2, 64);
+        RESIZE(glyph_upload.glyphs, glyph_upload.glyph_capacity);
+        RESIZE(glyph_upload.infos, glyph_upload.glyph_capacity);
+    }
+    if (glyph_upload.data_size + size > glyph_upload.data_capacity) {
+        glyph_upload.data_capacity = MAX(glyph_upload.data_capacity * 2,
+                glyph_upload.data_size + size);
+        RESIZE(glyph_upload.data, glyph_upload.data_capacity);
+    }
+
+    glyph_upload.glyphs[glyph_upload.number_of_glyphs] = glyph;
+    glyph_upload.infos[glyph_upload.number_of_glyphs] = *info;
+    glyph_upload.number_of_glyphs++;
+
+    bitmap = &glyph_upload.data[glyph_upload.data_size];
+    memset(bitmap, 0, size);
+    glyph_upload.data_size += size;
+    return bitmap;
+}
+
+/* Get the key identifying the glyphs rendered for @query.
+ *
+ * Besides the query, this includes the dpi and the name, style and number of
+ * glyphs of the faces so that the key changes when the fonts are updated.
+ */
+static char *get_glyph_cache_key(const utf8_t *query)
+{
+    char *key, *next_key;
+    FT_Face face;
+
+    key = xasprintf("%s\n%" PRIu32, query, resources.dpi);
+    for (uint32_t i = 0; i < font.number_of_primary_faces; i++) {
+        face = font.faces[i];
+        next_key = xasprintf("%s\n%s %s %ld", key,
+                face->family_name == NULL ? "" : face->family_name,
+                face->style_name == NULL ? "" : face->style_name,
+                (long) face->num_glyphs);
+        free(key);
+        key = next_key;
+    }
+    return key;
+}
+
+/* Get the path of the glyph cache file for @key and create the directories
+ * leading up to it.
+ */
+static char *get_glyph_cache_path(const char *key)
+{
+    const char *cache_home;
+    char *directory, *path;
+    uint64_t hash;
+
+    /* FNV-1a hash of the key */
+    hash = UINT64_C(14695981039346656037);
+    for (; key[0] != '\0'; key++) {
+        hash ^= (uint8_t) key[0];
+        hash *= UINT64_C(1099511628211);
+    }
+
+    cache_home = getenv("XDG_CACHE_HOME");
+    if (cache_home != NULL && cache_home[0] != '\0') {
+        directory = xstrdup(cache_home);
+    } else {
+        directory = xasprintf("%s/.cache", Fensterchef_home);
+    }
+    (void) mkdir(directory, 0700);
+    path = xasprintf("%s/" FENSTERCHEF_NAME, directory);
+    free(directory);
+    (void) mkdir(path, 0700);
+
+    directory = path;
+    path = xasprintf("%s/glyphs-%016" PRIx64, directory, hash);
+    free(directory);
+    return path;
+}
+
+/* Get the size of @key padded to a multiple of 4. */
+static inline size_t get_padded_key_length(size_t key_length)
+{
+    return (key_length + (0x4 - 0x1)) & ~(0x4 - 0x1);
+}
+
+/* Upload all glyphs within the glyph cache file at @path.
+ *
+ * @return false if the file does not exist or does not belong to @key.
+ */
+static bool load_glyph_cache(const char *path, const char *key)
+{
+    int file;
+    struct stat file_stat;
+    uint8_t *map;
+    const struct glyph_cache_header *header;
+    const struct glyph_cache_record *record;
+    size_t key_length;
+    size_t offset;
+    uint32_t stride, bitmap_size;
+    struct glyph_metrics *metrics;
+    uint32_t count = 0;
+
+    file = open(path, O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+
+    if (fstat(file, &file_stat) < 0 ||
+            (size_t) file_stat.st_size < sizeof(*header)) {
+        close(file);
+        return false;
+    }
+
+    map = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    /* check that the file belongs to the key */
+    header = (struct glyph_cache_header*) map;
+    key_length = strlen(key);
+    offset = sizeof(*header) + get_padded_key_length(key_length);
+    if (memcmp(header->magic, GLYPH_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+            header->key_length != key_length ||
+            offset > (size_t) file_stat.st_size ||
+            memcmp(&header[1], key, key_length) != 0) {
+        munmap(map, file_stat.st_size);
+        return false;
+    }
+
+    /* upload all complete records, an incomplete record at the end may be
+     * left by an interrupted write
+     */
+    while (offset + sizeof(*record) <= (size_t) file_stat.st_size) {
+        record = (struct glyph_cache_record*) &map[offset];
+        offset += sizeof(*record);
+
+        stride = (record->info.width + (0x4 - 0x1)) & ~(0x4 - 0x1);
+        bitmap_size = stride * record->info.height;
+        if (record->glyph == 0 ||
+                offset + bitmap_size > (size_t) file_stat.st_size) {
+            break;
+        }
+
+        /* multiple instances of fensterchef might have appended the same
+         * glyph
+         */
+        if (font.glyph_capacity > 0 &&
+                find_glyph_slot(record->glyph)->glyph == record->glyph) {
+            offset += bitmap_size;
+            continue;
+        }
+
+        memcpy(queue_glyph_upload(record->glyph, &record->info, bitmap_size),
+                &map[offset], bitmap_size);
+        offset += bitmap_size;
+
+        metrics = add_glyph_metrics(record->glyph);
+        metrics->is_renderable = true;
+        metrics->advance = record->advance;
+        metrics->ascent = record->ascent;
+        metrics->descent = record->descent;
+        count++;
+    }
+
+    flush_glyph_upload();
+
+    munmap(map, file_stat.st_size);
+
+    LOG("loaded %" PRIu32 " glyphs from %s\n", count, path);
+    return true;
+}
+
+/* Load the glyph cache file of the current font and open it for appending. */
+static void open_glyph_cache(const utf8_t *query)
+{
+    char *key, *path;
+    struct glyph_cache_header header;
+    const char padding[4] = { 0 };
+    struct iovec vectors[3];
+    size_t key_length;
+    ssize_t expected;
+
+    key = get_glyph_cache_key(query);
+    path = get_glyph_cache_path(key);
+
+    if (load_glyph_cache(path, key)) {
+        font.cache_file = open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+    } else {
+        /* start a new file with just the header */
+        font.cache_file = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND |
+                O_CLOEXEC, 0600);
+        if (font.cache_file >= 0) {
+            key_length = strlen(key);
+            memcpy(header.magic, GLYPH_CACHE_MAGIC, sizeof(header.magic));
+            header.key_length = key_length;
+            vectors[0].iov_base = &header;
+            vectors[0].iov_len = sizeof(header);
+            vectors[1].iov_base = key;
+            vectors[1].iov_len = key_length;
+            vectors[2].iov_base = (void*) padding;
+            vectors[2].iov_len = get_padded_key_length(key_length) - key_length;
+            expected = sizeof(header) + get_padded_key_length(key_length);
+            if (writev(font.cache_file, vectors, SIZE(vectors)) != expected) {
+                close(font.cache_file);
+                font.cache_file = -1;
+            }
+        }
+    }
+
+    if (font.cache_file < 0) {
+        LOG_ERROR("could not open glyph cache file %s: %s\n",
+                path, strerror(errno));
+    }
+
+    free(path);
+    free(key);
+}
+
+/* Append a rendered glyph to the glyph cache file. */
+static void store_cached_glyph(const struct glyph_metrics *metrics,
+        const xcb_render_glyphinfo_t *info, const uint8_t *bitmap,
+        uint32_t bitmap_size)
+{
+    struct glyph_cache_record record;
+    struct iovec vectors[2];
+
+    record.glyph = metrics->glyph;
+    record.info = *info;
+    record.advance = metrics->advance;
+    record.ascent = metrics->ascent;
+    record.descent = metrics->descent;
+
+    /* write the record in one go so that concurrent writers do not interleave
+     */
+    vectors[0].iov_base = &record;
+    vectors[0].iov_len = sizeof(record);
+    vectors[1].iov_base = (void*) bitmap;
+    vectors[1].iov_len = bitmap_size;
+    if (writev(font.cache_file, vectors, SIZE(vectors)) !=
+            (ssize_t) (sizeof(record) + bitmap_size)) {
+        LOG_ERROR("could not write to the glyph cache file: %s\n",
+                strerror(errno));
+        close(font.cache_file);
+        font.cache_file = -1;
+    }
+}
+
+/* Add the glyph to the cache if not already cached.
+ *
+ * The glyph is only queued for uploading, `flush_glyph_upload()` must be called
+ * before it is used in a request.
+ *
+ * @return the metrics of the glyph or NULL if it can not be rendered.
+ */
+static const struct glyph_metrics *cache_glyph(uint32_t glyph)
+{
+    struct glyph_metrics *metrics;
     FT_Face face;
     xcb_render_glyphinfo_t glyph_info;
     uint32_t stride;
-    uint8_t *temporary_bitmap;
+    uint8_t *bitmap;
 
     if (glyph == 0) {
         return NULL;
     }
 
     /* check if the glyph is already cached */
-    if (FcCharSetHasChar(font.charset, glyph)) {
-        face = load_glyph(glyph, FT_LOAD_DEFAULT);
-        if (face == NULL) {
-            return NULL;
+    if (font.glyph_capacity > 0) {
+        metrics = find_glyph_slot(glyph);
+        if (metrics->glyph == glyph) {
+            return metrics->is_renderable ? metrics : NULL;
         }
-        return face;
     }
 
     /* find the face that has the glyph and load it */
@@ -438,6 +1077,11 @@ static FT_Face cache_glyph(uint32_t glyph)
         LOG_VERBOSE("could not load face for glyph: " COLOR(GREEN)
                     "U+%08" PRIx32 "\n",
                 glyph);
+        /* remember that the glyph can not be rendered so the expensive search
+         * for a face is not repeated
+         */
+        metrics = add_glyph_metrics(glyph);
+        metrics->is_renderable = false;
         return NULL;
     }
 
@@ -453,27 +1097,31 @@ static FT_Face cache_glyph(uint32_t glyph)
      * X renderer expects this
      */
     stride = (glyph_info.width + (0x4 - 0x1)) & ~(0x4 - 0x1);
-    temporary_bitmap = xcalloc(stride * glyph_info.height,
-            sizeof(*temporary_bitmap));
 
+    /* queue the glyph for adding it to the glyph set */
+    bitmap = queue_glyph_upload(glyph, &glyph_info,
+            stride * glyph_info.height);
     for (uint16_t y = 0; y < glyph_info.height; y++) {
-        memcpy(temporary_bitmap + y * stride,
+        memcpy(bitmap + y * stride,
                 face->glyph->bitmap.buffer + y * glyph_info.width,
                 glyph_info.width);
     }
 
-    /* add the glyph to the glyph set */
-    xcb_render_add_glyphs(connection,
-            font.glyphset, 1, &glyph, &glyph_info,
-            stride * glyph_info.height, temporary_bitmap);
-
-    free(temporary_bitmap);
-
     LOG_VERBOSE("cached glyph: " COLOR(GREEN) "U+%08" PRIx32 "\n", glyph);
 
-    /* mark the glyph as cached */
-    FcCharSetAddChar(font.charset, glyph);
-    return face;
+    /* remember the metrics */
+    metrics = add_glyph_metrics(glyph);
+    metrics->is_renderable = true;
+    /* dividing by 64 converts from 26.6 fractional points to pixels */
+    metrics->advance = face->glyph->advance.x / 64;
+    metrics->ascent = face->size->metrics.ascender / 64;
+    metrics->descent = face->size->metrics.descender / 64;
+
+    if (font.cache_file >= 0) {
+        store_cached_glyph(metrics, &glyph_info, bitmap,
+                stride * glyph_info.height);
+    }
+    return metrics;
 }
 
 /* Helper function to convert an RRGGBB color into an xcb color. */
@@ -512,7 +1160,7 @@ void draw_text_modern(xcb_drawable_t drawable, const utf8_t *utf8,
          */
         uint32_t glyphs[UINT8_MAX - 1];
     } glyphs;
-    FT_Face face;
+    const struct glyph_metrics *metrics;
     uint32_t text_width;
 
     /* get a picture to draw on */
@@ -538,17 +1186,19 @@ void draw_text_modern(xcb_drawable_t drawable, const utf8_t *utf8,
         while (glyphs.header.count < SIZE(glyphs.glyphs) && i < length) {
             U8_NEXT(utf8, i, length, glyph);
 
-            face = cache_glyph(glyph);
-            if (face == NULL) {
+            metrics = cache_glyph(glyph);
+            if (metrics == NULL) {
                 continue;
             }
 
             glyphs.glyphs[glyphs.header.count++] = glyph;
 
-            /* dividing by 64 converts from 26.6 fractional points to pixels */
-            text_width += face->glyph->advance.x / 64;
+            text_width += metrics->advance;
         }
 
+        /* upload the new glyphs before they are used */
+        flush_glyph_upload();
+
         /* send a render request to the X renderer */
         xcb_render_composite_glyphs_32(connection,
                 XCB_RENDER_PICT_OP_OVER, /* C = Ca + Cb * (1 - Aa) */
@@ -570,8 +1220,7 @@ void measure_text_modern(const utf8_t *utf8, uint32_t length,
         struct text_measure *measure)
 {
     uint32_t glyph;
-    FT_Face face;
-    FT_Short ascent, descent;
+    const struct glyph_metrics *metrics;
 
     measure->ascent = 0;
     measure->descent = 0;
@@ -582,18 +1231,17 @@ void measure_text_modern(const utf8_t *utf8, uint32_t length,
         U8_NEXT(utf8, i, length, glyph);
 
         /* load the char into the font */
-        face = cache_glyph(glyph);
-        if (face == NULL) {
+        metrics = cache_glyph(glyph);
+        if (metrics == NULL) {
             continue;
         }
 
-        /* dividing by 64 converts from 26.6 fractional points to pixels */
-        measure->total_width += face->glyph->advance.x / 64;
-        ascent = face->size->metrics.ascender / 64;
-        descent = face->size->metrics.descender / 64;
-
-        measure->ascent = MAX(measure->ascent, ascent);
-        measure->descent = MIN(measure->descent, descent);
+        measure->total_width += metrics->advance;
+        measure->ascent = MAX(measure->ascent, metrics->ascent);
+        measure->descent = MIN(measure->descent, metrics->descent);
     }
     measure->total_height = measure->ascent - measure->descent;
+
+    /* the glyphs are needed for drawing the text later anyway */
+    flush_glyph_upload();
 }
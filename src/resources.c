@@ -6,6 +6,7 @@
 #include <xcb/xcb.h>
 
 #include "fensterchef.h"
+#include "latency.h"
 #include "log.h"
 #include "resources.h"
 #include "x11_management.h"
@@ -27,6 +28,7 @@ void set_resource(const char *class, const char *name, const char *value,
      * Xcursor.size <integer>
      * Xcursor.anim <boolean>
      * Xcursor.resized <boolean>
+     * Xcursor.filter <string>
      * Xcursor.theme_core <boolean>
      */
     if (strcmp(class, "Xcursor") == 0 || class[0] == '\0') {
@@ -39,6 +41,8 @@ void set_resource(const char *class, const char *name, const char *value,
             xcursor_settings.animated = xcursor_string_to_boolean(value);
         } else if (strcmp(name, "resized") == 0) {
             xcursor_settings.resized = xcursor_string_to_boolean(value);
+        } else if (strcmp(name, "filter") == 0) {
+            set_xcursor_filter(value);
         } else if (strcmp(name, "theme_core") == 0) {
             xcursor_settings.theme_core = xcursor_string_to_boolean(value);
         }
@@ -136,7 +140,8 @@ void reload_resources(void)
     resource_cookie = xcb_get_property(connection, false, screen->root,
             XCB_ATOM_RESOURCE_MANAGER, XCB_ATOM_STRING, 0,
             16 * 1024 /* this should be big enough */);
-    resource = xcb_get_property_reply(connection, resource_cookie, NULL);
+    resource = ROUND_TRIP(xcb_get_property_reply(connection, resource_cookie,
+                NULL));
     if (resource != NULL) {
         /* need to create a copy because it is not null-terminated which is very
          * inconvenient
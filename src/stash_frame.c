@@ -11,6 +11,8 @@ static void hide_and_reference_inner_windows(Frame *frame)
         hide_window_abruptly(frame->window);
         /* make sure the pointer sticks around */
         reference_window(frame->window);
+        /* stashed windows are not part of the tiling layout */
+        frame->window->frame = NULL;
     }
 }
 
@@ -22,8 +24,10 @@ static void show_and_dereference_inner_windows(Frame *frame)
         show_and_dereference_inner_windows(frame->right);
     } else if (frame->window != NULL) {
         dereference_window(frame->window);
+        frame->window->frame = frame;
         reload_frame(frame);
         frame->window->state.is_visible = true;
+        mark_window_dirty(frame->window);
     }
 }
 
@@ -38,8 +42,10 @@ static uint32_t validate_inner_windows(Frame *frame)
             validate_inner_windows(frame->right);
     } else if (frame->window != NULL) {
         if (frame->window->client.id == XCB_NONE) {
-            dereference_window(frame->window);
-            frame->window = NULL;
+            Window *const window = frame->window;
+
+            set_frame_window(frame, NULL);
+            dereference_window(window);
             return 0;
         }
         return 1;
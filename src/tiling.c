@@ -1,6 +1,7 @@
 #include <inttypes.h>
 
 #include "configuration.h"
+#include "ipc.h"
 #include "log.h"
 #include "size_frame.h"
 #include "stash_frame.h"
@@ -32,8 +33,8 @@ void split_frame(Frame *split_from, Frame *other, bool is_left_split,
         new->left->parent = new;
         new->right->parent = new;
     } else {
-        new->window = split_from->window;
-        split_from->window = NULL;
+        set_frame_window(new, split_from->window);
+        set_frame_window(split_from, NULL);
     }
 
     split_from->split_direction = direction;
@@ -62,6 +63,11 @@ void split_frame(Frame *split_from, Frame *other, bool is_left_split,
     }
 
     LOG("split %F(%F, %F)\n", split_from, new, other);
+
+    publish_ipc_event(IPC_EVENT_FRAME_SPLIT,
+            "%" PRId32 " %" PRId32 " %" PRIu32 " %" PRIu32,
+            split_from->x, split_from->y,
+            split_from->width, split_from->height);
 }
 
 /* Remove a frame from the screen. */
@@ -101,9 +107,9 @@ void remove_frame(Frame *frame)
         other->left = NULL;
         other->right = NULL;
     } else {
-        parent->window = other->window;
+        set_frame_window(parent, other->window);
 
-        other->window = NULL;
+        set_frame_window(other, NULL);
     }
     /* disconnect `other`, it will be destroyed later */
     other->parent = NULL;
@@ -113,6 +119,10 @@ void remove_frame(Frame *frame)
 
     LOG("frame %F was removed\n", frame);
 
+    publish_ipc_event(IPC_EVENT_FRAME_REMOVED,
+            "%" PRId32 " %" PRId32 " %" PRIu32 " %" PRIu32,
+            frame->x, frame->y, frame->width, frame->height);
+
     /* do not leave behind broken focus */
     if (Frame_focus == frame || Frame_focus == other) {
         Frame *new;
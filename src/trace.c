@@ -0,0 +1,276 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "event.h"
+#include "frame.h"
+#include "log.h"
+#include "trace.h"
+#include "utility.h"
+#include "window.h"
+#include "window_properties.h"
+#include "xalloc.h"
+
+/* the identifier at the start of a trace file */
+#define TRACE_MAGIC "fctrace1"
+
+/* the records start after this many bytes */
+#define TRACE_HEADER_SIZE 4096
+
+/* the header at the start of a trace file */
+struct trace_header {
+    /* `TRACE_MAGIC` */
+    char magic[8];
+    /* the size of a single record */
+    uint32_t record_size;
+    /* the number of records the file holds */
+    uint32_t capacity;
+    /* the total number of records written */
+    uint64_t count;
+    /* the first randr event or 0 if randr is not available */
+    uint32_t randr_event_base;
+    /* the number of atoms in `atoms` */
+    uint32_t number_of_atoms;
+    /* the values of all atoms in `x_atoms` */
+    uint32_t atoms[ATOM_MAX];
+};
+
+/* the path of the trace file or `NULL` if no trace should be written */
+char *trace_path;
+
+/* if a trace is currently written */
+bool is_tracing;
+
+/* the mapped trace file */
+static struct trace_file {
+    /* the mapped memory */
+    void *data;
+    /* the size of the mapped memory */
+    size_t size;
+    /* the header at the start of `data` */
+    struct trace_header *header;
+    /* the records after the header */
+    TraceRecord *records;
+    /* the time the trace was started */
+    uint64_t start_time;
+} trace_file;
+
+/* Create the trace file at `trace_path`. */
+int initialize_trace(void)
+{
+    char *old_path;
+    int fd;
+    struct trace_header *header;
+
+    if (trace_path == NULL || is_tracing) {
+        return OK;
+    }
+
+    /* keep the trace of the last session */
+    old_path = xasprintf("%s.old", trace_path);
+    (void) rename(trace_path, old_path);
+    free(old_path);
+
+    fd = open(trace_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        LOG_ERROR("could not create trace file %s: %s\n",
+                trace_path, strerror(errno));
+        return ERROR;
+    }
+
+    trace_file.size = TRACE_HEADER_SIZE +
+        sizeof(TraceRecord) * TRACE_MAXIMUM_RECORDS;
+    if (ftruncate(fd, trace_file.size) == -1) {
+        LOG_ERROR("could not resize trace file %s: %s\n",
+                trace_path, strerror(errno));
+        close(fd);
+        return ERROR;
+    }
+
+    trace_file.data = mmap(NULL, trace_file.size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+    close(fd);
+    if (trace_file.data == MAP_FAILED) {
+        LOG_ERROR("could not map trace file %s: %s\n",
+                trace_path, strerror(errno));
+        return ERROR;
+    }
+
+    header = trace_file.data;
+    memcpy(header->magic, TRACE_MAGIC, sizeof(header->magic));
+    header->record_size = sizeof(TraceRecord);
+    header->capacity = TRACE_MAXIMUM_RECORDS;
+    header->count = 0;
+    header->randr_event_base = randr_event_base;
+    header->number_of_atoms = ATOM_MAX;
+    for (uint32_t i = 0; i < ATOM_MAX; i++) {
+        header->atoms[i] = x_atoms[i].atom;
+    }
+
+    trace_file.header = header;
+    trace_file.records = (TraceRecord*)
+        &((char*) trace_file.data)[TRACE_HEADER_SIZE];
+    trace_file.start_time = get_monotonic_time();
+
+    LOG("writing trace to %s\n", trace_path);
+
+    is_tracing = true;
+    return OK;
+}
+
+/* Unmap and close the trace file. */
+void deinitialize_trace(void)
+{
+    if (!is_tracing) {
+        return;
+    }
+
+    munmap(trace_file.data, trace_file.size);
+    is_tracing = false;
+}
+
+/* Get the next record and fill in the common fields. */
+static TraceRecord *add_trace_record(trace_kind_t kind, uint64_t start)
+{
+    TraceRecord *record;
+    uint64_t end;
+
+    record = &trace_file.records[trace_file.header->count %
+        TRACE_MAXIMUM_RECORDS];
+    trace_file.header->count++;
+
+    end = get_monotonic_time();
+    record->time = start - trace_file.start_time;
+    record->duration = MIN(end - start, UINT32_MAX);
+    record->frame = Frame_focus == NULL ? 0 : Frame_focus->number;
+    record->action = ACTION_NULL;
+    record->kind = kind;
+    record->event_type = 0;
+    return record;
+}
+
+/* Add a record for an @event whose handling started at @start. */
+void trace_event(const xcb_generic_event_t *event, uint64_t start)
+{
+    TraceRecord *record;
+
+    if (!is_tracing) {
+        return;
+    }
+
+    record = add_trace_record(TRACE_KIND_EVENT, start);
+    record->window = Window_focus == NULL ? XCB_NONE :
+        Window_focus->client.id;
+    record->event_type = event->response_type & ~0x80;
+    memcpy(record->event, event, sizeof(record->event));
+}
+
+/* Add a record for an @action done on @window that started at @start. */
+void trace_action(const Action *action, xcb_window_t window, uint64_t start)
+{
+    TraceRecord *record;
+
+    if (!is_tracing) {
+        return;
+    }
+
+    record = add_trace_record(TRACE_KIND_ACTION, start);
+    record->window = window;
+    record->action = action->code;
+}
+
+/* Print a single trace record to standard output. */
+static void print_trace_record(const TraceRecord *record)
+{
+    xcb_generic_event_t event;
+
+    print_formatted(stdout, "%" PRIu64 ".%06" PRIu64 " ",
+            record->time / 1000000000,
+            record->time / 1000 % 1000000);
+
+    switch (record->kind) {
+    case TRACE_KIND_EVENT:
+        /* the stored event lacks the trailing `full_sequence` */
+        memcpy(&event, record->event, sizeof(record->event));
+        event.full_sequence = 0;
+        print_formatted(stdout, "%V", &event);
+        break;
+
+    case TRACE_KIND_ACTION:
+        print_formatted(stdout, COLOR(CYAN) "%s" CLEAR_COLOR,
+                record->action < ACTION_MAX ?
+                    action_to_string(record->action) : "?");
+        break;
+
+    default:
+        print_formatted(stdout, "RECORD[%" PRIu8 "]", record->kind);
+        break;
+    }
+
+    print_formatted(stdout, " took %" PRIu32 "us window=%w frame=%" PRIu32
+                "\n",
+            record->duration / 1000, record->window, record->frame);
+}
+
+/* Print all records within the trace file at @path to standard output. */
+int decode_trace(const char *path)
+{
+    int fd;
+    struct stat file_stat;
+    void *data;
+    const struct trace_header *header;
+    const TraceRecord *records;
+    uint64_t first;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        fprintf(stderr, "could not open %s: %s\n", path, strerror(errno));
+        return ERROR;
+    }
+
+    if (fstat(fd, &file_stat) == -1 ||
+            (size_t) file_stat.st_size < TRACE_HEADER_SIZE) {
+        fprintf(stderr, "%s is not a trace file\n", path);
+        close(fd);
+        return ERROR;
+    }
+
+    data = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "could not map %s: %s\n", path, strerror(errno));
+        return ERROR;
+    }
+
+    header = data;
+    if (memcmp(header->magic, TRACE_MAGIC, sizeof(header->magic)) != 0 ||
+            header->record_size != sizeof(TraceRecord) ||
+            header->capacity == 0 ||
+            (size_t) file_stat.st_size < TRACE_HEADER_SIZE +
+                (size_t) header->capacity * sizeof(TraceRecord)) {
+        fprintf(stderr, "%s is not a trace file\n", path);
+        munmap(data, file_stat.st_size);
+        return ERROR;
+    }
+
+    /* restore the server specific values so the printers know them */
+    randr_event_base = header->randr_event_base;
+    for (uint32_t i = 0; i < MIN(header->number_of_atoms, ATOM_MAX); i++) {
+        x_atoms[i].atom = header->atoms[i];
+    }
+
+    records = (const TraceRecord*) &((const char*) data)[TRACE_HEADER_SIZE];
+    first = header->count > header->capacity ?
+        header->count - header->capacity : 0;
+    for (uint64_t i = first; i < header->count; i++) {
+        print_trace_record(&records[i % header->capacity]);
+    }
+
+    munmap(data, file_stat.st_size);
+    return OK;
+}
@@ -3,7 +3,10 @@
 
 #include "configuration.h"
 #include "event.h"
+#include "fensterchef.h"
 #include "frame.h"
+#include "ipc.h"
+#include "latency.h"
 #include "log.h"
 #include "monitor.h"
 #include "window.h"
@@ -18,6 +21,9 @@ uint32_t Window_count;
 /* the window that was created before any other */
 Window *Window_oldest;
 
+/* the window that was created after all others */
+Window *Window_newest;
+
 /* the window at the bottom of the Z stack */
 Window *Window_bottom;
 
@@ -30,6 +36,132 @@ Window *Window_first;
 /* the currently focused window */
 Window *Window_focus;
 
+/* the first window in the dirty linked list */
+Window *Window_first_dirty;
+
+/* the minimum number of slots in the window map */
+#define WINDOW_MAP_MINIMUM_CAPACITY 64
+
+/* The window map is used to find windows by their X window id without going
+ * through the entire number linked list.
+ *
+ * It is a hash map using open addressing with linear probing. The capacity is
+ * always a power of two and at most half of the slots are in use.
+ */
+static struct {
+    /* the slots of the map, NULL marks an empty slot */
+    Window **windows;
+    /* the number of slots */
+    uint32_t capacity;
+    /* the number of used slots */
+    uint32_t count;
+    /* the number of bits to shift the hash to the right so that it fits into
+     * the capacity
+     */
+    uint32_t shift;
+} window_map;
+
+/* Get the slot index a window with given X window id ideally has. */
+static inline uint32_t get_window_map_hash(xcb_window_t xcb_window)
+{
+    /* Fibonacci hashing, X server ids are mostly sequential which this
+     * spreads out well
+     */
+    return (uint32_t) (xcb_window * UINT32_C(2654435769)) >> window_map.shift;
+}
+
+/* Put @window into the window map without checking the capacity. */
+static void insert_into_window_map(Window *window)
+{
+    uint32_t index;
+
+    index = get_window_map_hash(window->client.id);
+    while (window_map.windows[index] != NULL) {
+        index = (index + 1) & (window_map.capacity - 1);
+    }
+    window_map.windows[index] = window;
+}
+
+/* Double the capacity of the window map and rehash all windows. */
+static void grow_window_map(void)
+{
+    Window **old_windows;
+    uint32_t old_capacity;
+
+    old_windows = window_map.windows;
+    old_capacity = window_map.capacity;
+
+    if (window_map.capacity == 0) {
+        window_map.capacity = WINDOW_MAP_MINIMUM_CAPACITY;
+        window_map.shift = 32;
+        for (uint32_t i = window_map.capacity; i > 1; i >>= 1) {
+            window_map.shift--;
+        }
+    } else {
+        window_map.capacity *= 2;
+        window_map.shift--;
+    }
+    window_map.windows = xcalloc(window_map.capacity,
+            sizeof(*window_map.windows));
+
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        if (old_windows[i] != NULL) {
+            insert_into_window_map(old_windows[i]);
+        }
+    }
+    free(old_windows);
+}
+
+/* Add @window to the window map, its X window id must be set. */
+static void add_window_to_map(Window *window)
+{
+    /* keep the load factor at or below 1/2 */
+    if ((window_map.count + 1) * 2 > window_map.capacity) {
+        grow_window_map();
+    }
+    insert_into_window_map(window);
+    window_map.count++;
+}
+
+/* Remove @window from the window map. */
+static void remove_window_from_map(Window *window)
+{
+    uint32_t mask;
+    uint32_t index, next, ideal;
+
+    if (window_map.count == 0) {
+        return;
+    }
+
+    mask = window_map.capacity - 1;
+    index = get_window_map_hash(window->client.id);
+    while (window_map.windows[index] != window) {
+        if (window_map.windows[index] == NULL) {
+            LOG_ERROR("window %W is not in the window map\n", window);
+            return;
+        }
+        index = (index + 1) & mask;
+    }
+
+    /* shift following entries back so no probe sequence gets interrupted by
+     * the new gap
+     */
+    next = index;
+    while (next = (next + 1) & mask, window_map.windows[next] != NULL) {
+        ideal = get_window_map_hash(window_map.windows[next]->client.id);
+        /* check if the ideal slot lies cyclically outside of (index, next],
+         * then the entry can be moved into the gap
+         */
+        if (index <= next ? (ideal <= index || ideal > next) :
+                (ideal <= index && ideal > next)) {
+            window_map.windows[index] = window_map.windows[next];
+            index = next;
+        }
+    }
+    window_map.windows[index] = NULL;
+    window_map.count--;
+}
+
 /* Increment the reference count of the window. */
 inline void reference_window(Window *window)
 {
@@ -47,39 +179,99 @@ inline void dereference_window(Window *window)
     }
 }
 
-/* Find where in the number linked list a gap is.
- *
- * @return NULL when the window should be inserted before the first window.
- */
-static inline Window *find_number_gap(void)
+/* Mark the window as changed. */
+void mark_window_dirty(Window *window)
 {
-    Window *previous;
+    if (window->state.mode == WINDOW_MODE_DOCK) {
+        are_monitors_dirty = true;
+    }
+
+    if (window->is_dirty) {
+        return;
+    }
 
-    /* if the first window has window number greater than the first number that
-     * means there is space at the front
+    /* the reference is dropped again when the window is synchronized, this
+     * allows the window to be destroyed while in the list
      */
-    if (Window_first->number > (uint32_t)
-            configuration.assignment.first_window_number) {
-        return NULL;
+    reference_window(window);
+    window->is_dirty = true;
+    window->next_dirty = Window_first_dirty;
+    Window_first_dirty = window;
+}
+
+/* Mark all windows as dirty. */
+void mark_all_windows_dirty(void)
+{
+    for (Window *window = Window_first; window != NULL;
+            window = window->next) {
+        mark_window_dirty(window);
     }
+}
 
-    previous = Window_first;
-    /* find the first window with a higher number than
-     * `first_window_number`
+/* window numbers below this limit are tracked in `window_numbers`, windows
+ * with a higher number are still sorted into the number linked list but finding
+ * their position requires walking the list
+ */
+#define WINDOW_NUMBER_LIMIT 4096
+
+/* bookkeeping of the window numbers in use so that neither finding a free
+ * number nor finding the position within the number linked list needs to walk
+ * through all windows
+ */
+static struct window_numbers {
+    /* the last window in the number linked list with the number used as
+     * index, NULL if the number is unused
      */
-    for (; previous->next != NULL; previous = previous->next) {
-        if (previous->next->number > (uint32_t)
-                configuration.assignment.first_window_number) {
-            break;
-        }
+    Window **last;
+    /* the number of entries within `last` */
+    uint32_t capacity;
+    /* all numbers from `hint_first` up to (excluding) `free_hint` are in use */
+    uint32_t hint_first;
+    uint32_t free_hint;
+} window_numbers;
+
+/* Remember that @window is the last window with its number. */
+static void track_window_number(Window *window)
+{
+    uint32_t capacity;
+
+    if (window->number >= WINDOW_NUMBER_LIMIT) {
+        return;
     }
-    /* find a gap in the window numbers */
-    for (; previous->next != NULL; previous = previous->next) {
-        if (previous->number + 1 < previous->next->number) {
-            break;
+
+    if (window->number >= window_numbers.capacity) {
+        capacity = MAX(window_numbers.capacity * 2, window->number + 1);
+        capacity = MAX(capacity, 32);
+        capacity = MIN(capacity, WINDOW_NUMBER_LIMIT);
+        RESIZE(window_numbers.last, capacity);
+        memset(&window_numbers.last[window_numbers.capacity], 0,
+                sizeof(*window_numbers.last) *
+                    (capacity - window_numbers.capacity));
+        window_numbers.capacity = capacity;
+    }
+
+    window_numbers.last[window->number] = window;
+}
+
+/* Forget about @window being the last window with its number.
+ *
+ * @previous is the window before @window in the number linked list.
+ */
+static void untrack_window_number(Window *window, Window *previous)
+{
+    if (window->number >= window_numbers.capacity ||
+            window_numbers.last[window->number] != window) {
+        return;
+    }
+
+    if (previous != NULL && previous->number == window->number) {
+        window_numbers.last[window->number] = previous;
+    } else {
+        window_numbers.last[window->number] = NULL;
+        if (window->number < window_numbers.free_hint) {
+            window_numbers.free_hint = window->number;
         }
     }
-    return previous;
 }
 
 /* Find the window after which a new window with given @number should be
@@ -87,30 +279,95 @@ static inline Window *find_number_gap(void)
  *
  * @return NULL when the window should be inserted before the first window.
  */
-static inline Window *find_window_number(uint32_t number)
+static Window *find_window_number(uint32_t number)
 {
-    Window *previous;
+    Window *previous = NULL;
 
     if (Window_first == NULL || Window_first->number > number) {
         return NULL;
     }
 
-    previous = Window_first;
-    /* find a gap in the window numbers */
-    for (; previous->next != NULL; previous = previous->next) {
-        if (previous->next->number > number) {
+    /* find the closest tracked number that is in use */
+    for (uint32_t i = MIN(number + 1, window_numbers.capacity); i > 0; i--) {
+        if (window_numbers.last[i - 1] != NULL) {
+            previous = window_numbers.last[i - 1];
             break;
         }
     }
+
+    if (previous == NULL) {
+        previous = Window_first;
+    }
+
+    /* this only walks when the number is outside the tracked range */
+    while (previous->next != NULL && previous->next->number <= number) {
+        previous = previous->next;
+    }
     return previous;
 }
 
-/* Create a window struct and add it to the window list. */
-Window *create_window(xcb_window_t xcb_window,
+/* Find the lowest window number not in use starting from
+ * `first_window_number`.
+ */
+static uint32_t find_free_number(void)
+{
+    const uint32_t first = configuration.assignment.first_window_number;
+    uint32_t number;
+    Window *previous;
+
+    /* the hint is invalid when the configuration changed */
+    if (window_numbers.hint_first != first) {
+        window_numbers.hint_first = first;
+        window_numbers.free_hint = first;
+    }
+
+    number = MAX(window_numbers.free_hint, first);
+    while (number < window_numbers.capacity &&
+            window_numbers.last[number] != NULL) {
+        number++;
+    }
+
+    /* walk the list for numbers that are not tracked */
+    if (number >= WINDOW_NUMBER_LIMIT) {
+        previous = find_window_number(number);
+        while (previous != NULL && previous->number == number) {
+            number++;
+            while (previous->next != NULL && previous->next->number <= number) {
+                previous = previous->next;
+            }
+        }
+    }
+
+    window_numbers.free_hint = number;
+    return number;
+}
+
+/* Send all requests needed to create a window for @xcb_window. */
+void send_window_requests(xcb_window_t xcb_window,
+        struct window_requests *requests)
+{
+    requests->id = xcb_window;
+    requests->attributes = xcb_get_window_attributes(connection, xcb_window);
+    requests->geometry = xcb_get_geometry(connection, xcb_window);
+    /* we want to know if if any properties change, this must be selected
+     * before requesting the properties so no change is missed in between
+     */
+    general_values[0] = XCB_EVENT_MASK_PROPERTY_CHANGE;
+    xcb_change_window_attributes(connection, xcb_window, XCB_CW_EVENT_MASK,
+            general_values);
+    /* already send the property requests so that all replies arrive in one
+     * go
+     */
+    request_window_properties(xcb_window, &requests->properties);
+}
+
+/* Create a window struct from the replies of @requests and add it to the
+ * window list.
+ */
+Window *create_window_from_replies(const struct window_requests *requests,
         struct configuration_association *association)
 {
-    xcb_get_window_attributes_cookie_t attributes_cookie;
-    xcb_get_geometry_cookie_t geometry_cookie;
+    const xcb_window_t xcb_window = requests->id;
     xcb_generic_error_t *error;
     xcb_get_window_attributes_reply_t *attributes;
     xcb_get_geometry_reply_t *geometry;
@@ -118,16 +375,14 @@ Window *create_window(xcb_window_t xcb_window,
     Window *previous;
     window_mode_t mode;
 
-    attributes_cookie = xcb_get_window_attributes(connection, xcb_window);
-    geometry_cookie = xcb_get_geometry(connection, xcb_window);
-
-    attributes = xcb_get_window_attributes_reply(connection, attributes_cookie,
-            &error);
+    attributes = ROUND_TRIP(xcb_get_window_attributes_reply(connection,
+                requests->attributes, &error));
     if (attributes == NULL) {
         LOG_ERROR("could not get window attributes of %w: %E\n",
                 xcb_window, error);
         free(error);
-        xcb_discard_reply(connection, geometry_cookie.sequence);
+        xcb_discard_reply(connection, requests->geometry.sequence);
+        discard_window_properties(&requests->properties);
         return NULL;
     }
 
@@ -138,26 +393,15 @@ Window *create_window(xcb_window_t xcb_window,
     if (attributes->override_redirect ||
             attributes->_class == XCB_WINDOW_CLASS_INPUT_ONLY) {
         free(attributes);
-        xcb_discard_reply(connection, geometry_cookie.sequence);
+        xcb_discard_reply(connection, requests->geometry.sequence);
+        discard_window_properties(&requests->properties);
 
         /* check if the window holds a command */
         char *const command = get_fensterchef_command_property(xcb_window);
         if (command != NULL) {
-            struct configuration configuration;
-
             LOG("window %#" PRIx32 " has command: %s\n", xcb_window, command);
 
-            if (load_configuration(command, &configuration, false) == OK) {
-                LOG("doing its actions: %A\n",
-                        configuration.startup.number_of_actions,
-                        configuration.startup.actions);
-                for (uint32_t i = 0;
-                        i < configuration.startup.number_of_actions;
-                        i++) {
-                    do_action(&configuration.startup.actions[i], Window_focus);
-                }
-                clear_configuration(&configuration);
-            }
+            run_command(command);
 
             free(command);
 
@@ -170,22 +414,21 @@ Window *create_window(xcb_window_t xcb_window,
         return NULL;
     }
 
-    geometry = xcb_get_geometry_reply(connection, geometry_cookie,
-            &error);
+    geometry = ROUND_TRIP(xcb_get_geometry_reply(connection,
+                requests->geometry, &error));
     if (geometry == NULL) {
         LOG_ERROR("could not get window geometry of %w: %E\n",
                 xcb_window, error);
         free(attributes);
         free(error);
+        discard_window_properties(&requests->properties);
         return NULL;
     }
 
     /* set the initial border color */
     general_values[0] = configuration.border.color;
-    /* we want to know if if any properties change */
-    general_values[1] = XCB_EVENT_MASK_PROPERTY_CHANGE;
-    xcb_change_window_attributes(connection, xcb_window,
-            XCB_CW_BORDER_PIXEL | XCB_CW_EVENT_MASK, general_values);
+    xcb_change_window_attributes(connection, xcb_window, XCB_CW_BORDER_PIXEL,
+            general_values);
 
     window = xcalloc(1, sizeof(*window));
 
@@ -214,66 +457,55 @@ Window *create_window(xcb_window_t xcb_window,
     window->border_color = window->client.border_color;
 
     /* get the initial mode and set the window number */
-    mode = initialize_window_properties(window, association);
+    mode = initialize_window_properties(window, &requests->properties,
+            association);
     window->number = association->number;
 
-    /* link into the Z, age and number linked lists */
-    if (Window_first == NULL) {
+    if (window->number == 0) {
+        window->number = find_free_number();
+    }
+
+    /* link into the number linked list */
+    previous = find_window_number(window->number);
+    if (previous == NULL) {
+        window->next = Window_first;
+        Window_first = window;
+    } else {
+        window->next = previous->next;
+        previous->next = window;
+    }
+    track_window_number(window);
+
+    /* link into the Z and age linked lists */
+    if (Window_oldest == NULL) {
         Window_oldest = window;
         Window_bottom = window;
         Window_top = window;
-        Window_first = window;
-        if (window->number == 0) {
-            window->number = configuration.assignment.first_window_number;
-        }
     } else {
-        previous = Window_first;
-        if (window->number == 0) {
-            previous = find_number_gap();
-        } else {
-            previous = find_window_number(window->number);
-        }
-
-        if (previous == NULL) {
-            window->next = Window_first;
-            Window_first = window;
-            if (window->number == 0) {
-                window->number = configuration.assignment.first_window_number;
-            }
-        } else {
-            if (window->number == 0) {
-                if (previous->number < (uint32_t)
-                        configuration.assignment.first_window_number) {
-                    window->number =
-                        configuration.assignment.first_window_number;
-                } else {
-                    window->number = previous->number + 1;
-                }
-            }
-            window->next = previous->next;
-            previous->next = window;
-        }
-
         /* put the window at the top of the Z linked list */
         window->below = Window_top;
         Window_top->above = window;
         Window_top = window;
 
-        /* put the window into the age linked list */
-        previous = Window_oldest;
-        while (previous->newer != NULL) {
-            previous = previous->newer;
-        }
-        previous->newer = window;
+        /* put the window at the end of the age linked list */
+        Window_newest->newer = window;
     }
+    Window_newest = window;
 
     /* new window is now in the list */
     Window_count++;
 
+    add_window_to_map(window);
+
+    publish_ipc_event(IPC_EVENT_WINDOW_CREATED, "%#" PRIx32 " %" PRIu32,
+            window->client.id, window->number);
+
     /* initialize the window mode and Z position */
     set_window_mode(window, mode);
     update_window_layer(window);
 
+    mark_window_dirty(window);
+
     has_client_list_changed = true;
 
     /* grab the buttons for this window */
@@ -283,6 +515,16 @@ Window *create_window(xcb_window_t xcb_window,
     return window;
 }
 
+/* Create a window struct and add it to the window list. */
+Window *create_window(xcb_window_t xcb_window,
+        struct configuration_association *association)
+{
+    struct window_requests requests;
+
+    send_window_requests(xcb_window, &requests);
+    return create_window_from_replies(&requests, association);
+}
+
 /* Remove @window from the Z linked list. */
 static void unlink_window_from_z_list(Window *window)
 {
@@ -326,7 +568,7 @@ void destroy_window(Window *window)
     /* this should also never happen but we check just in case */
     frame = get_frame_of_window(window);
     if (frame != NULL) {
-        frame->window = NULL;
+        set_frame_window(frame, NULL);
         LOG_ERROR("window being destroyed is still within a frame\n");
     }
 
@@ -338,6 +580,7 @@ void destroy_window(Window *window)
     /* remove from the age linked list */
     if (Window_oldest == window) {
         Window_oldest = Window_oldest->newer;
+        previous = NULL;
     } else {
         previous = Window_oldest;
         while (previous->newer != window) {
@@ -345,10 +588,14 @@ void destroy_window(Window *window)
         }
         previous->newer = window->newer;
     }
+    if (Window_newest == window) {
+        Window_newest = previous;
+    }
 
     /* remove from the number linked list */
     if (Window_first == window) {
         Window_first = Window_first->next;
+        previous = NULL;
     } else {
         previous = Window_first;
         while (previous->next != window) {
@@ -356,15 +603,22 @@ void destroy_window(Window *window)
         }
         previous->next = window->next;
     }
+    untrack_window_number(window, previous);
 
     /* window is gone from the list now */
     Window_count--;
 
+    remove_window_from_map(window);
+
+    publish_ipc_event(IPC_EVENT_WINDOW_DESTROYED, "%#" PRIx32 " %" PRIu32,
+            window->client.id, window->number);
+
     has_client_list_changed = true;
 
     /* setting the id to None marks the window as destroyed */
     window->client.id = XCB_NONE;
     free(window->name);
+    free(window->list_entry.text);
     free(window->protocols);
     free(window->states);
 
@@ -549,6 +803,8 @@ void set_window_size(Window *window, int32_t x, int32_t y, uint32_t width,
     window->height = height;
 
     place_window_in_bounds(window);
+
+    mark_window_dirty(window);
 }
 
 /* Links the window into the z linked list at a specific place and synchronizes
@@ -639,6 +895,9 @@ void update_window_layer(Window *window)
 
     link_window_into_z_list(below, window);
 
+    /* the top window might have changed which affects the border color */
+    mark_window_dirty(window);
+
     /* put windows that are transient for this window above it */
     for (below = window->below; below != NULL; below = below->below) {
         if (below->transient_for == window->client.id) {
@@ -651,32 +910,21 @@ void update_window_layer(Window *window)
 /* Get the internal window that has the associated xcb window. */
 Window *get_window_of_xcb_window(xcb_window_t xcb_window)
 {
-    for (Window *window = Window_first; window != NULL;
-            window = window->next) {
-        if (window->client.id == xcb_window) {
-            return window;
-        }
-    }
-    return NULL;
-}
-
-/* Checks if @frame contains @window and checks this for all its children. */
-static Frame *find_frame_recursively(Frame *frame, const Window *window)
-{
-    if (frame->window == window) {
-        return frame;
-    }
+    uint32_t index;
+    Window *window;
 
-    if (frame->left == NULL) {
+    if (window_map.count == 0) {
         return NULL;
     }
 
-    Frame *const find = find_frame_recursively(frame->left, window);
-    if (find != NULL) {
-        return find;
+    index = get_window_map_hash(xcb_window);
+    while (window = window_map.windows[index], window != NULL) {
+        if (window->client.id == xcb_window) {
+            return window;
+        }
+        index = (index + 1) & (window_map.capacity - 1);
     }
-
-    return find_frame_recursively(frame->right, window);
+    return NULL;
 }
 
 /* Get the frame this window is contained in. */
@@ -687,14 +935,7 @@ Frame *get_frame_of_window(const Window *window)
         return NULL;
     }
 
-    for (Monitor *monitor = Monitor_first; monitor != NULL;
-            monitor = monitor->next) {
-        Frame *const find = find_frame_recursively(monitor->frame, window);
-        if (find != NULL) {
-            return find;
-        }
-    }
-    return NULL;
+    return window->frame;
 }
 
 /* Check if @window accepts input focus. */
@@ -11,6 +11,7 @@
 #include "fensterchef.h"
 #include "frame.h"
 #include "keymap.h"
+#include "latency.h"
 #include "log.h"
 #include "monitor.h"
 #include "render.h"
@@ -30,6 +31,7 @@ int initialize_window_list(void)
     const char *window_list_name = "[fensterchef] window list";
 
     window_list.client.id = xcb_generate_id(connection);
+    window_list.buffer.window = window_list.client.id;
     window_list.client.x = -1;
     window_list.client.y = -1;
     window_list.client.width = 1;
@@ -45,14 +47,15 @@ int initialize_window_list(void)
     /* get key press events, focus change events and expose events */
     general_values[3] = XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_EXPOSURE |
         XCB_EVENT_MASK_FOCUS_CHANGE;
-    error = xcb_request_check(connection, xcb_create_window_checked(connection,
+    error = ROUND_TRIP(xcb_request_check(connection,
+            xcb_create_window_checked(connection,
                 XCB_COPY_FROM_PARENT, window_list.client.id,
                 screen->root, window_list.client.x, window_list.client.y,
                 window_list.client.width, window_list.client.height,
                 window_list.client.border_width, XCB_WINDOW_CLASS_INPUT_OUTPUT,
                 XCB_COPY_FROM_PARENT, XCB_CW_BACK_PIXEL | XCB_CW_BORDER_PIXEL |
                     XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK,
-                    general_values));
+                    general_values)));
     if (error != NULL) {
         LOG_ERROR("could not create window list window: %E\n", error);
         free(error);
@@ -78,12 +81,54 @@ static inline char get_indicator_character(Window *window)
             window->state.mode == WINDOW_MODE_FULLSCREEN ? 'F' : '+';
 }
 
-/* Get a string representation of a window. */
-static inline void get_window_string(Window *window, utf8_t *buffer,
-        size_t buffer_size)
+/* Drop the cached window list entry of @window. */
+void invalidate_window_list_entry(Window *window)
 {
-    snprintf((char*) buffer, buffer_size, "%" PRIu32 "%c%s",
-            window->number, get_indicator_character(window), window->name);
+    free(window->list_entry.text);
+    window->list_entry.text = NULL;
+}
+
+/* Drop the cached window list entries of all windows. */
+void invalidate_all_window_list_entries(void)
+{
+    for (Window *window = Window_first; window != NULL; window = window->next) {
+        invalidate_window_list_entry(window);
+    }
+}
+
+/* Get the window list entry of a window, build and measure the text if the
+ * cached one is outdated.
+ */
+static const struct window_list_entry *get_window_entry(Window *window)
+{
+    struct window_list_entry *entry;
+    char indicator;
+    utf8_t buffer[256];
+    struct text_measure measure;
+
+    entry = &window->list_entry;
+    indicator = get_indicator_character(window);
+    if (entry->text != NULL && entry->number == window->number &&
+            entry->indicator == indicator) {
+        return entry;
+    }
+
+    snprintf((char*) buffer, sizeof(buffer), "%" PRIu32 "%c%s",
+            window->number, indicator,
+            window->name == NULL ? "" : (char*) window->name);
+
+    free(entry->text);
+    entry->text = (utf8_t*) xstrdup((char*) buffer);
+    entry->is_drawn = false;
+    entry->length = strlen((char*) buffer);
+    entry->number = window->number;
+    entry->indicator = indicator;
+
+    measure_text(entry->text, entry->length, &measure);
+    entry->ascent = measure.ascent;
+    entry->width = measure.total_width;
+    entry->height = measure.total_height;
+    return entry;
 }
 
 /* Get the window currently selected in the window list. */
@@ -107,15 +152,17 @@ static Window *get_selected_window(void)
 /* Render the window list. */
 static void render_window_list(void)
 {
-    utf8_t                  buffer[256];
     uint32_t                window_count;
-    struct text_measure     measure;
+    const struct window_list_entry *entry = NULL;
     uint32_t                height_per_item;
     uint32_t                max_width;
     Monitor                 *monitor;
     uint32_t                index;
     uint32_t                maximum_item;
     xcb_rectangle_t         rectangle;
+    uint32_t                row;
+    bool                    is_redrawn;
+    uint32_t                first_damaged, last_damaged;
 
     /* measure the maximum needed width and count the windows */
     window_count = 0;
@@ -126,9 +173,8 @@ static void render_window_list(void)
         }
 
         window_count++;
-        get_window_string(window, buffer, sizeof(buffer));
-        measure_text(buffer, strlen((char*) buffer), &measure);
-        max_width = MAX(max_width, measure.total_width);
+        entry = get_window_entry(window);
+        max_width = MAX(max_width, entry->width);
     }
 
     /* unmap the window list if there are no more windows */
@@ -139,7 +185,7 @@ static void render_window_list(void)
 
     window_list.selected = MIN(window_list.selected, window_count - 1);
 
-    height_per_item = measure.total_height + configuration.notification.padding;
+    height_per_item = entry->height + configuration.notification.padding;
 
     if (Window_focus == NULL || Frame_focus->window == Window_focus) {
         monitor = get_monitor_containing_frame(Frame_focus);
@@ -174,14 +220,46 @@ static void render_window_list(void)
             maximum_item * height_per_item,
             window_list.client.border_width);
 
-    /* render the items showing the window names */
     rectangle.x = 0;
     rectangle.y = 0;
     rectangle.width = max_width + configuration.notification.padding / 2;
     rectangle.height = height_per_item;
+
+    /* all rows need to be drawn again if the back buffer is new or the size of
+     * the rows changed
+     */
+    is_redrawn = resize_back_buffer(&window_list.buffer, rectangle.width,
+            maximum_item * height_per_item);
+    if (rectangle.width != window_list.drawn_width ||
+            height_per_item != window_list.drawn_height) {
+        is_redrawn = true;
+        window_list.drawn_width = rectangle.width;
+        window_list.drawn_height = height_per_item;
+    }
+    /* forget about rows that are no longer within the back buffer */
+    if (is_redrawn) {
+        for (row = 0; row < window_list.number_of_drawn_rows; row++) {
+            window_list.drawn_rows[row].window = NULL;
+        }
+    }
+    if (maximum_item > window_list.number_of_drawn_rows) {
+        RESIZE(window_list.drawn_rows, maximum_item);
+        for (row = window_list.number_of_drawn_rows; row < maximum_item;
+                row++) {
+            window_list.drawn_rows[row].window = NULL;
+        }
+        window_list.number_of_drawn_rows = maximum_item;
+    }
+
+    /* render the items showing the window names, only the rows that changed
+     * are drawn
+     */
+    first_damaged = UINT32_MAX;
+    last_damaged = 0;
     index = 0;
     for (Window *window = Window_first; window != NULL; window = window->next) {
         uint32_t background_color, foreground_color;
+        bool is_selected;
 
         if (!is_window_in_window_list(window)) {
             continue;
@@ -197,8 +275,25 @@ static void render_window_list(void)
             break;
         }
 
+        row = index - 1 - window_list.vertical_scrolling;
+        rectangle.y = row * height_per_item;
+        is_selected = index - 1 == window_list.selected;
+
+        /* skip the row if it still shows the same */
+        if (!is_redrawn && window->list_entry.is_drawn &&
+                window_list.drawn_rows[row].window == window &&
+                window_list.drawn_rows[row].is_selected == is_selected) {
+            continue;
+        }
+
+        window_list.drawn_rows[row].window = window;
+        window_list.drawn_rows[row].is_selected = is_selected;
+        window->list_entry.is_drawn = true;
+        first_damaged = MIN(first_damaged, row);
+        last_damaged = row;
+
         /* use normal or inverted colors */
-        if (index - 1 != window_list.selected) {
+        if (!is_selected) {
             foreground_color = configuration.notification.foreground;
             background_color = configuration.notification.background;
         } else {
@@ -207,14 +302,20 @@ static void render_window_list(void)
         }
 
         /* draw the text centered within the item */
-        get_window_string(window, buffer, sizeof(buffer));
-        draw_text(window_list.client.id, buffer, strlen((char*) buffer),
-                background_color, &rectangle,
+        fill_back_buffer(&window_list.buffer, &rectangle, background_color);
+        draw_text(window_list.buffer.pixmap, window->list_entry.text,
+                window->list_entry.length, background_color, NULL,
                 foreground_color, configuration.notification.padding / 2,
-                rectangle.y + measure.ascent +
+                rectangle.y + entry->ascent +
                     configuration.notification.padding / 2);
+    }
 
-        rectangle.y += rectangle.height;
+    /* copy all changed rows onto the window at once */
+    if (first_damaged <= last_damaged) {
+        rectangle.y = first_damaged * height_per_item;
+        rectangle.height = (last_damaged - first_damaged + 1) *
+            height_per_item;
+        present_back_buffer(&window_list.buffer, &rectangle);
     }
 }
 
@@ -296,6 +397,23 @@ static void handle_key_press(xcb_key_press_event_t *event)
     }
 }
 
+/* Handle an Expose event. */
+static void handle_expose(xcb_expose_event_t *event)
+{
+    xcb_rectangle_t rectangle;
+
+    if (event->window != window_list.client.id) {
+        return;
+    }
+
+    /* copy the exposed region from the back buffer */
+    rectangle.x = event->x;
+    rectangle.y = event->y;
+    rectangle.width = event->width;
+    rectangle.height = event->height;
+    present_back_buffer(&window_list.buffer, &rectangle);
+}
+
 /* Handle a FocusOut event. */
 static void handle_focus_out(xcb_focus_out_event_t *event)
 {
@@ -339,6 +457,11 @@ void handle_window_list_event(xcb_generic_event_t *event)
     case 0:
         return;
 
+    /* a part of the window list needs to be shown again */
+    case XCB_EXPOSE:
+        handle_expose((xcb_expose_event_t*) event);
+        break;
+
     /* a key was pressed */
     case XCB_KEY_PRESS:
         handle_key_press((xcb_key_press_event_t*) event);
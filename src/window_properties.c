@@ -1,9 +1,11 @@
 #include <string.h>
 
 #include "configuration.h"
+#include "latency.h"
 #include "log.h"
 #include "utility.h"
 #include "window.h"
+#include "window_list.h"
 #include "window_properties.h"
 
 struct x_atoms x_atoms[] = {
@@ -28,7 +30,8 @@ int initialize_atoms(void)
      * server assigned for us
      */
     for (uint32_t i = 0; i < ATOM_MAX; i++) {
-        atom = xcb_intern_atom_reply(connection, atom_cookies[i], &error);
+        atom = ROUND_TRIP(xcb_intern_atom_reply(connection, atom_cookies[i],
+                    &error));
         if (atom == NULL) {
             LOG_ERROR("could not intern atom %s: %E", x_atoms[i].name, error);
             free(error);
@@ -117,50 +120,73 @@ void initialize_root_properties(void)
 }
 
 
-/* Wrapper around getting a cookie and reply for a GetProperty request. */
-static inline xcb_get_property_reply_t *get_property(
-        xcb_window_t window, xcb_atom_t property, xcb_atom_t type,
-        uint32_t format, uint32_t length)
+/* Send a GetProperty request for @property of @window.
+ *
+ * @length is the number of 32-bit values to request.
+ */
+static inline xcb_get_property_cookie_t request_property(xcb_window_t window,
+        xcb_atom_t property, xcb_atom_t type, uint32_t length)
+{
+    return xcb_get_property(connection, false, window, property, type, 0,
+            length);
+}
+
+/* Get the reply of a GetProperty request and check its format.
+ *
+ * The time waiting for the reply is accounted to @file and @line.
+ *
+ * @return NULL if the property is not set or misformatted.
+ */
+static xcb_get_property_reply_t *get_property_reply_at(const char *file,
+        int line, xcb_window_t window, xcb_atom_t property,
+        xcb_get_property_cookie_t cookie, uint32_t format, uint32_t length)
 {
-    xcb_get_property_cookie_t cookie;
     xcb_get_property_reply_t *reply;
 
-    cookie = xcb_get_property(connection, false, window, property, type, 0,
-            length);
-    reply = xcb_get_property_reply(connection, cookie, NULL);
+    reply = ROUND_TRIP_AT(file, line,
+            xcb_get_property_reply(connection, cookie, NULL));
     /* check if the property is in the needed format and if it is long enough */
     if (reply != NULL && (reply->format != format || (uint32_t)
             xcb_get_property_value_length(reply) < length * format / 8)) {
-        LOG("window %w has misformatted property %a\n", window, property);
+        /* a format of 0 means the property is simply not set */
+        if (reply->format != 0) {
+            LOG("window %w has misformatted property %a\n", window, property);
+        }
         free(reply);
         reply = NULL;
     }
     return reply;
 }
 
-/* Wrapper around getting a cookie and reply for a GetProperty request. */
-static inline xcb_get_property_reply_t *get_text_property(xcb_window_t window,
-        xcb_atom_t property)
+/* Get the reply of a GetProperty request and check its format. */
+#define get_property_reply(window, property, cookie, format, length) \
+    get_property_reply_at(__FILE__, __LINE__, (window), (property), \
+            (cookie), (format), (length))
+
+/* Send a GetProperty request for a text property. */
+static inline xcb_get_property_cookie_t request_text_property(
+        xcb_window_t window, xcb_atom_t property)
 {
-    xcb_get_property_cookie_t cookie;
-    xcb_get_property_reply_t *reply;
+    return request_property(window, property, XCB_GET_PROPERTY_TYPE_ANY, 2048);
+}
 
-    cookie = xcb_get_property(connection, false, window, property,
-            XCB_GET_PROPERTY_TYPE_ANY, 0, 2048);
-    reply = xcb_get_property_reply(connection, cookie, NULL);
-    if (reply->format == 0) {
-        free(reply);
-        reply = NULL;
-    }
-    /* check if the property is in the needed format */
-    if (reply != NULL && reply->format != 8) {
-        LOG("window %w has misformatted property %a\n", window, property);
-        free(reply);
-        reply = NULL;
-    }
-    return reply;
+/* Get the reply of a GetProperty request for a text property. */
+#define get_text_property_reply(window, property, cookie) \
+    get_property_reply_at(__FILE__, __LINE__, (window), (property), \
+            (cookie), 8, 0)
+
+/* Wrapper around getting a cookie and reply for a GetProperty request. */
+static inline xcb_get_property_reply_t *get_text_property_at(const char *file,
+        int line, xcb_window_t window, xcb_atom_t property)
+{
+    return get_property_reply_at(file, line, window, property,
+            request_text_property(window, property), 8, 0);
 }
 
+/* Wrapper around getting a cookie and reply for a GetProperty request. */
+#define get_text_property(window, property) \
+    get_text_property_at(__FILE__, __LINE__, (window), (property))
+
 /* Gets the `FENSTERCHEF_COMMAND` property from @window. */
 char *get_fensterchef_command_property(xcb_window_t window)
 {
@@ -178,18 +204,75 @@ char *get_fensterchef_command_property(xcb_window_t window)
     return command;
 }
 
-/* Update the name within @properties. */
-static void update_window_name(Window *window)
+/* Send a GetProperty request for a list of atoms. */
+static inline xcb_get_property_cookie_t request_atom_list(xcb_window_t window,
+        xcb_atom_t atom)
+{
+    /* get up to 32 atoms from this property */
+    return request_property(window, atom, XCB_ATOM_ATOM, 32);
+}
+
+/* Get a window property as list of atoms from the reply of @cookie.
+ *
+ * The time waiting for the reply is accounted to @file and @line.
+ *
+ * @return a list of atoms terminated by `XCB_NONE` or NULL if the property is
+ *         not set.
+ */
+static xcb_atom_t *get_atom_list_reply_at(const char *file, int line,
+        xcb_get_property_cookie_t cookie)
+{
+    xcb_get_property_reply_t *reply;
+    xcb_atom_t *atoms;
+
+    reply = ROUND_TRIP_AT(file, line,
+            xcb_get_property_reply(connection, cookie, NULL));
+    if (reply == NULL) {
+        return NULL;
+    }
+    /* a format of 0 means the property is simply not set */
+    if (reply->format != 32) {
+        free(reply);
+        return NULL;
+    }
+    atoms = xmalloc(xcb_get_property_value_length(reply) + sizeof(*atoms));
+    memcpy(atoms, xcb_get_property_value(reply),
+            xcb_get_property_value_length(reply));
+    atoms[xcb_get_property_value_length(reply) / sizeof(xcb_atom_t)] = XCB_NONE;
+    free(reply);
+    return atoms;
+}
+
+/* Get a window property as list of atoms from the reply of @cookie. */
+#define get_atom_list_reply(cookie) \
+    get_atom_list_reply_at(__FILE__, __LINE__, (cookie))
+
+/* Send the requests for the name of @window. */
+static void request_window_name(xcb_window_t window,
+        struct window_property_cookies *cookies)
+{
+    cookies->net_name = request_text_property(window, ATOM(_NET_WM_NAME));
+    cookies->name = request_text_property(window, XCB_ATOM_WM_NAME);
+}
+
+/* Set the name within @window from the replies of @cookies. */
+static void receive_window_name(Window *window,
+        const struct window_property_cookies *cookies)
 {
     xcb_get_property_reply_t *name;
 
     free(window->name);
     window->name = NULL;
+    invalidate_window_list_entry(window);
 
-    name = get_text_property(window->client.id, ATOM(_NET_WM_NAME));
+    name = get_text_property_reply(window->client.id, ATOM(_NET_WM_NAME),
+            cookies->net_name);
     /* try to fall back to `WM_NAME` */
     if (name == NULL) {
-        name = get_text_property(window->client.id, XCB_ATOM_WM_NAME);
+        name = get_text_property_reply(window->client.id, XCB_ATOM_WM_NAME,
+                cookies->name);
+    } else {
+        xcb_discard_reply(connection, cookies->name.sequence);
     }
 
     if (name != NULL) {
@@ -201,109 +284,108 @@ static void update_window_name(Window *window)
     }
 }
 
-/* Update the size_hints within @properties. */
-static void update_window_size_hints(Window *window)
+/* Set the size_hints within @window from the reply of @cookies. */
+static void receive_window_size_hints(Window *window,
+        const struct window_property_cookies *cookies)
 {
-    xcb_get_property_cookie_t size_hints_cookie;
-
-    size_hints_cookie = xcb_icccm_get_wm_size_hints(connection,
-            window->client.id, XCB_ATOM_WM_NORMAL_HINTS);
-    if (!xcb_icccm_get_wm_size_hints_reply(connection, size_hints_cookie,
-                &window->size_hints, NULL)) {
+    if (!ROUND_TRIP_STATUS(xcb_icccm_get_wm_size_hints_reply(connection,
+                    cookies->size_hints, &window->size_hints, NULL))) {
         window->size_hints.flags = 0;
     }
 }
 
-/* Update the hints within @properties. */
-static void update_window_hints(Window *window)
+/* Set the hints within @window from the reply of @cookies. */
+static void receive_window_hints(Window *window,
+        const struct window_property_cookies *cookies)
 {
-    xcb_get_property_cookie_t hints_cookie;
-
-    hints_cookie = xcb_icccm_get_wm_hints(connection, window->client.id);
-    if (!xcb_icccm_get_wm_hints_reply(connection, hints_cookie,
-                &window->hints, NULL)) {
+    if (!ROUND_TRIP_STATUS(xcb_icccm_get_wm_hints_reply(connection,
+                    cookies->hints, &window->hints, NULL))) {
         window->hints.flags = 0;
     }
 }
 
-/* Update the strut partial property within @properties. */
-static void update_window_strut(Window *window)
+/* Send the requests for the strut of @window. */
+static void request_window_strut(xcb_window_t window,
+        struct window_property_cookies *cookies)
+{
+    cookies->strut_partial = request_property(window,
+            ATOM(_NET_WM_STRUT_PARTIAL), XCB_ATOM_CARDINAL,
+            sizeof(wm_strut_partial_t) / sizeof(uint32_t));
+    cookies->strut = request_property(window,
+            ATOM(_NET_WM_STRUT), XCB_ATOM_CARDINAL,
+            sizeof(Extents) / sizeof(uint32_t));
+}
+
+/* Set the strut within @window from the replies of @cookies. */
+static void receive_window_strut(Window *window,
+        const struct window_property_cookies *cookies)
 {
     xcb_get_property_reply_t *strut;
 
     memset(&window->strut, 0, sizeof(window->strut));
 
-    strut = get_property(window->client.id,
-            ATOM(_NET_WM_STRUT_PARTIAL), XCB_ATOM_CARDINAL, 32,
+    strut = get_property_reply(window->client.id,
+            ATOM(_NET_WM_STRUT_PARTIAL), cookies->strut_partial, 32,
             sizeof(wm_strut_partial_t) / sizeof(uint32_t));
     if (strut == NULL) {
         /* `_NET_WM_STRUT` is older than `_NET_WM_STRUT_PARTIAL`, fall back to
          * it when there is no strut partial
          */
-        strut = get_property(window->client.id,
-                ATOM(_NET_WM_STRUT), XCB_ATOM_CARDINAL, 32,
+        strut = get_property_reply(window->client.id,
+                ATOM(_NET_WM_STRUT), cookies->strut, 32,
                 sizeof(Extents) / sizeof(uint32_t));
         if (strut != NULL) {
             window->strut.reserved = *(Extents*) xcb_get_property_value(strut);
         }
     } else {
+        xcb_discard_reply(connection, cookies->strut.sequence);
         window->strut = *(wm_strut_partial_t*) xcb_get_property_value(strut);
     }
 
     free(strut);
-}
-
-/* Get a window property as list of atoms. */
-static inline xcb_atom_t *get_atom_list(xcb_window_t window, xcb_atom_t atom)
-{
-    xcb_get_property_cookie_t cookie;
-    xcb_get_property_reply_t *reply;
-    xcb_atom_t *atoms;
 
-    /* get up to 32 atoms from this property */
-    cookie = xcb_get_property(connection, 0, window, atom, XCB_ATOM_ATOM,
-            0, sizeof(atom) * 32);
-    reply = xcb_get_property_reply(connection, cookie, NULL);
-    if (reply == NULL) {
-        return NULL;
-    }
-    atoms = xmalloc(xcb_get_property_value_length(reply) + sizeof(*atoms));
-    memcpy(atoms, xcb_get_property_value(reply),
-            xcb_get_property_value_length(reply));
-    atoms[xcb_get_property_value_length(reply) / sizeof(xcb_atom_t)] = XCB_NONE;
-    free(reply);
-    return atoms;
+    mark_window_dirty(window);
 }
 
-/* Update the `transient_for` property within @window. */
-static void update_window_transient_for(Window *window)
+/* Set the `transient_for` property within @window from the reply of
+ * @cookies.
+ */
+static void receive_window_transient_for(Window *window,
+        const struct window_property_cookies *cookies)
 {
-    xcb_get_property_cookie_t transient_for_cookie;
-
-    transient_for_cookie = xcb_icccm_get_wm_transient_for(connection,
-            window->client.id);
-    if (!xcb_icccm_get_wm_transient_for_reply(connection, transient_for_cookie,
-                &window->transient_for, NULL)) {
+    if (!ROUND_TRIP_STATUS(xcb_icccm_get_wm_transient_for_reply(connection,
+                    cookies->transient_for, &window->transient_for, NULL))) {
         window->transient_for = XCB_NONE;
     }
 }
 
-/* Update the `protocols` property within @window. */
-static void update_window_protocols(Window *window)
+/* Set the `protocols` property within @window from the reply of @cookies. */
+static void receive_window_protocols(Window *window,
+        const struct window_property_cookies *cookies)
 {
     free(window->protocols);
-    window->protocols = get_atom_list(window->client.id,
-            ATOM(WM_PROTOCOLS));
+    window->protocols = get_atom_list_reply(cookies->protocols);
 }
 
-/* Update the `fullscreen_monitors` property within @window. */
-static void update_window_fullscreen_monitors(Window *window)
+/* Send the request for the `fullscreen_monitors` property of @window. */
+static inline xcb_get_property_cookie_t request_window_fullscreen_monitors(
+        xcb_window_t window)
+{
+    return request_property(window, ATOM(_NET_WM_FULLSCREEN_MONITORS),
+            XCB_ATOM_CARDINAL, sizeof(Extents) / sizeof(uint32_t));
+}
+
+/* Set the `fullscreen_monitors` property within @window from the reply of
+ * @cookies.
+ */
+static void receive_window_fullscreen_monitors(Window *window,
+        const struct window_property_cookies *cookies)
 {
     xcb_get_property_reply_t *monitors;
 
-    monitors = get_property(window->client.id,
-            ATOM(_NET_WM_FULLSCREEN_MONITORS), XCB_ATOM_CARDINAL, 32,
-            sizeof(window->fullscreen_monitors) / sizeof(uint32_t));
+    monitors = get_property_reply(window->client.id,
+            ATOM(_NET_WM_FULLSCREEN_MONITORS), cookies->fullscreen_monitors,
+            32, sizeof(window->fullscreen_monitors) / sizeof(uint32_t));
     if (monitors == NULL) {
         memset(&window->fullscreen_monitors, 0,
                 sizeof(window->fullscreen_monitors));
@@ -314,22 +396,37 @@ static void update_window_fullscreen_monitors(Window *window)
     }
 }
 
-/* Update `is_borderless` within @window base on `_MOTIF_WM_HINTS`. */
-static void update_motif_wm_hints(Window *window)
+/* the motif hints as they are stored within `_MOTIF_WM_HINTS` */
+struct motif_wm_hints {
+    /* what fields below are available */
+    uint32_t flags;
+    /* IGNORED */
+    uint32_t functions;
+    /* border/frame decoration flags */
+    uint32_t decorations;
+    /* IGNORED */
+    uint32_t input_mode;
+    /* IGNORED */
+    uint32_t status;
+};
+
+/* Send the request for the `_MOTIF_WM_HINTS` property of @window. */
+static inline xcb_get_property_cookie_t request_motif_wm_hints(
+        xcb_window_t window)
+{
+    return request_property(window, ATOM(_MOTIF_WM_HINTS),
+            ATOM(_MOTIF_WM_HINTS),
+            sizeof(struct motif_wm_hints) / sizeof(uint32_t));
+}
+
+/* Set `is_borderless` within @window base on the `_MOTIF_WM_HINTS` reply of
+ * @cookies.
+ */
+static void receive_motif_wm_hints(Window *window,
+        const struct window_property_cookies *cookies)
 {
     xcb_get_property_reply_t *motif_wm_hints;
-    struct motif_wm_hints {
-        /* what fields below are available */
-        uint32_t flags;
-        /* IGNORED */
-        uint32_t functions;
-        /* border/frame decoration flags */
-        uint32_t decorations;
-        /* IGNORED */
-        uint32_t input_mode;
-        /* IGNORED */
-        uint32_t status;
-    } hints;
+    struct motif_wm_hints hints;
 
     const uint32_t decorations_flag = (1 << 1);
     const uint32_t decorate_all = (1 << 0);
@@ -337,8 +434,8 @@ static void update_motif_wm_hints(Window *window)
 
     window->is_borderless = false;
 
-    motif_wm_hints = get_property(window->client.id,
-            ATOM(_MOTIF_WM_HINTS), ATOM(_MOTIF_WM_HINTS), 32,
+    motif_wm_hints = get_property_reply(window->client.id,
+            ATOM(_MOTIF_WM_HINTS), cookies->motif_wm_hints, 32,
             sizeof(hints) / sizeof(uint32_t));
     if (motif_wm_hints != NULL) {
         hints = *(struct motif_wm_hints*)
@@ -361,40 +458,52 @@ static void update_motif_wm_hints(Window *window)
 /* Update the property within @window corresponding to given atom. */
 bool cache_window_property(Window *window, xcb_atom_t atom)
 {
+    const xcb_window_t id = window->client.id;
+    struct window_property_cookies cookies;
+
     /* this is spaced out because it was very difficult to read with the eyes */
     if (atom == XCB_ATOM_WM_NAME || atom == ATOM(_NET_WM_NAME)) {
 
-        update_window_name(window);
+        request_window_name(id, &cookies);
+        receive_window_name(window, &cookies);
 
     } else if (atom == XCB_ATOM_WM_NORMAL_HINTS ||
             atom == XCB_ATOM_WM_SIZE_HINTS) {
 
-        update_window_size_hints(window);
+        cookies.size_hints = xcb_icccm_get_wm_size_hints(connection, id,
+                XCB_ATOM_WM_NORMAL_HINTS);
+        receive_window_size_hints(window, &cookies);
 
     } else if (atom == XCB_ATOM_WM_HINTS) {
 
-        update_window_hints(window);
+        cookies.hints = xcb_icccm_get_wm_hints(connection, id);
+        receive_window_hints(window, &cookies);
 
     } else if (atom == ATOM(_NET_WM_STRUT) ||
             atom == ATOM(_NET_WM_STRUT_PARTIAL)) {
 
-        update_window_strut(window);
+        request_window_strut(id, &cookies);
+        receive_window_strut(window, &cookies);
 
     } else if (atom == XCB_ATOM_WM_TRANSIENT_FOR) {
 
-        update_window_transient_for(window);
+        cookies.transient_for = xcb_icccm_get_wm_transient_for(connection, id);
+        receive_window_transient_for(window, &cookies);
 
     } else if (atom == ATOM(WM_PROTOCOLS)) {
 
-        update_window_protocols(window);
+        cookies.protocols = request_atom_list(id, ATOM(WM_PROTOCOLS));
+        receive_window_protocols(window, &cookies);
 
     } else if (atom == ATOM(_NET_WM_FULLSCREEN_MONITORS)) {
 
-        update_window_fullscreen_monitors(window);
+        cookies.fullscreen_monitors = request_window_fullscreen_monitors(id);
+        receive_window_fullscreen_monitors(window, &cookies);
 
     } else if (atom == ATOM(_MOTIF_WM_HINTS)) {
 
-        update_motif_wm_hints(window);
+        cookies.motif_wm_hints = request_motif_wm_hints(id);
+        receive_motif_wm_hints(window, &cookies);
 
     } else {
         return false;
@@ -416,62 +525,99 @@ static bool is_atom_included(const xcb_atom_t *atoms, xcb_atom_t atom)
     return false;
 }
 
-/* Initialize all properties within @properties. */
+/* Send the requests for all properties of @window we care about. */
+void request_window_properties(xcb_window_t window,
+        struct window_property_cookies *cookies)
+{
+    cookies->class = request_text_property(window, XCB_ATOM_WM_CLASS);
+    request_window_name(window, cookies);
+    cookies->size_hints = xcb_icccm_get_wm_size_hints(connection, window,
+            XCB_ATOM_WM_NORMAL_HINTS);
+    cookies->hints = xcb_icccm_get_wm_hints(connection, window);
+    request_window_strut(window, cookies);
+    cookies->transient_for = xcb_icccm_get_wm_transient_for(connection, window);
+    cookies->protocols = request_atom_list(window, ATOM(WM_PROTOCOLS));
+    cookies->fullscreen_monitors = request_window_fullscreen_monitors(window);
+    cookies->motif_wm_hints = request_motif_wm_hints(window);
+    cookies->states = request_atom_list(window, ATOM(_NET_WM_STATE));
+    cookies->types = request_atom_list(window, ATOM(_NET_WM_WINDOW_TYPE));
+}
+
+/* Throw away the replies of all requests within @cookies. */
+void discard_window_properties(const struct window_property_cookies *cookies)
+{
+    const xcb_get_property_cookie_t all_cookies[] = {
+        cookies->class,
+        cookies->net_name,
+        cookies->name,
+        cookies->size_hints,
+        cookies->hints,
+        cookies->strut_partial,
+        cookies->strut,
+        cookies->transient_for,
+        cookies->protocols,
+        cookies->fullscreen_monitors,
+        cookies->motif_wm_hints,
+        cookies->states,
+        cookies->types,
+    };
+
+    for (uint32_t i = 0; i < SIZE(all_cookies); i++) {
+        xcb_discard_reply(connection, all_cookies[i].sequence);
+    }
+}
+
+/* Initialize all properties within @window from the replies of @cookies. */
 window_mode_t initialize_window_properties(Window *window,
+        const struct window_property_cookies *cookies,
         struct configuration_association *output_association)
 {
-    xcb_list_properties_cookie_t list_properties_cookie;
-    xcb_list_properties_reply_t *list_properties;
     xcb_get_property_reply_t *wm_class;
     const char *wm_class_value;
     int wm_class_length;
     int instance_length;
     utf8_t *instance_name = NULL;
     utf8_t *class_name = NULL;
-    xcb_atom_t *atoms;
-    int atom_count;
-    xcb_atom_t *states = NULL;
-    xcb_atom_t *types = NULL;
+    xcb_atom_t *states;
+    xcb_atom_t *types;
     window_mode_t predicted_mode = WINDOW_MODE_TILING;
 
     memset(output_association, 0, sizeof(*output_association));
 
-    /* get a list of properties currently set on the window */
-    list_properties_cookie = xcb_list_properties(connection, window->client.id);
-    list_properties = xcb_list_properties_reply(connection,
-            list_properties_cookie, NULL);
-    if (list_properties == NULL) {
-        return predicted_mode;
-    }
-
-    /* cache all properties */
-    atoms = xcb_list_properties_atoms(list_properties);
-    atom_count = xcb_list_properties_atoms_length(list_properties);
-    for (int i = 0; i < atom_count; i++) {
-        if (atoms[i] == XCB_ATOM_WM_CLASS) {
-            wm_class = get_text_property(window->client.id, XCB_ATOM_WM_CLASS);
-            wm_class_value = xcb_get_property_value(wm_class);
-            wm_class_length = xcb_get_property_value_length(wm_class);
-
-            instance_length = strnlen((char*) wm_class_value, wm_class_length);
-            instance_name = xmalloc(instance_length + 1);
-            memcpy(instance_name, wm_class_value, instance_length);
-            instance_name[instance_length] = '\0';
-
+    /* collect the replies in the order they were requested in, all requests
+     * were sent at once so this only waits for a single round trip
+     */
+    wm_class = get_text_property_reply(window->client.id, XCB_ATOM_WM_CLASS,
+            cookies->class);
+    if (wm_class != NULL) {
+        wm_class_value = xcb_get_property_value(wm_class);
+        wm_class_length = xcb_get_property_value_length(wm_class);
+
+        instance_length = strnlen((char*) wm_class_value, wm_class_length);
+        instance_name = xmalloc(instance_length + 1);
+        memcpy(instance_name, wm_class_value, instance_length);
+        instance_name[instance_length] = '\0';
+
+        if (instance_length < wm_class_length) {
             class_name = (utf8_t*) xstrndup(
                     &wm_class_value[instance_length + 1],
-                    wm_class_length - instance_length);
-
-            free(wm_class);
-        } else if (atoms[i] == ATOM(_NET_WM_STATE)) {
-            states = get_atom_list(window->client.id, ATOM(_NET_WM_STATE));
-        } else if (atoms[i] == ATOM(_NET_WM_WINDOW_TYPE)) {
-            types = get_atom_list(window->client.id, ATOM(_NET_WM_WINDOW_TYPE));
-        } else {
-            cache_window_property(window, atoms[i]);
+                    wm_class_length - instance_length - 1);
         }
+
+        free(wm_class);
     }
 
+    receive_window_name(window, cookies);
+    receive_window_size_hints(window, cookies);
+    receive_window_hints(window, cookies);
+    receive_window_strut(window, cookies);
+    receive_window_transient_for(window, cookies);
+    receive_window_protocols(window, cookies);
+    receive_window_fullscreen_monitors(window, cookies);
+    receive_motif_wm_hints(window, cookies);
+    states = get_atom_list_reply(cookies->states);
+    types = get_atom_list_reply(cookies->types);
+
     /* these are three direct checks */
     if (is_atom_included(states, ATOM(_NET_WM_STATE_FULLSCREEN)) ||
             is_atom_included(states, ATOM(_NET_WM_STATE_MAXIMIZED_HORZ)) ||
@@ -524,7 +670,6 @@ window_mode_t initialize_window_properties(Window *window,
     free(instance_name);
     free(class_name);
     free(types);
-    free(list_properties);
 
     return predicted_mode;
 }
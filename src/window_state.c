@@ -2,6 +2,7 @@
 
 #include "configuration.h"
 #include "frame.h"
+#include "ipc.h"
 #include "log.h"
 #include "monitor.h"
 #include "stash_frame.h"
@@ -405,19 +406,19 @@ static void update_shown_window(Window *window)
         if (frame != NULL) {
             LOG("found frame %F matching the window id\n", frame);
             (void) stash_frame(frame);
-            frame->window = window;
+            set_frame_window(frame, window);
             reload_frame(frame);
             break;
         }
 
         if (configuration.tiling.auto_split && Frame_focus->window != NULL) {
             Frame *const wrap = create_frame();
-            wrap->window = window;
+            set_frame_window(wrap, window);
             split_frame(Frame_focus, wrap, false, Frame_focus->split_direction);
             Frame_focus = wrap;
         } else {
             stash_frame(Frame_focus);
-            Frame_focus->window = window;
+            set_frame_window(Frame_focus, window);
             reload_frame(Frame_focus);
         }
         break;
@@ -448,6 +449,16 @@ static void update_shown_window(Window *window)
     }
 }
 
+/* the names of the window modes as sent to subscribed clients */
+static const char *window_mode_names[WINDOW_MODE_MAX + 1] = {
+    [WINDOW_MODE_TILING] = "tiling",
+    [WINDOW_MODE_FLOATING] = "floating",
+    [WINDOW_MODE_FULLSCREEN] = "fullscreen",
+    [WINDOW_MODE_DOCK] = "dock",
+    [WINDOW_MODE_DESKTOP] = "desktop",
+    [WINDOW_MODE_MAX] = "none",
+};
+
 /* Changes the window state to given value and reconfigures the window only
  * if the mode changed.
  */
@@ -462,6 +473,11 @@ void set_window_mode(Window *window, window_mode_t mode)
     LOG("transition window mode of %W from %m to %m\n", window,
             window->state.mode, mode);
 
+    /* a dock window stopping to be one changes the monitor struts */
+    if (window->state.mode == WINDOW_MODE_DOCK) {
+        are_monitors_dirty = true;
+    }
+
     /* this is true if the window is being initialized */
     if (window->state.mode == WINDOW_MODE_MAX) {
         window->state.previous_mode = mode;
@@ -470,6 +486,9 @@ void set_window_mode(Window *window, window_mode_t mode)
     }
     window->state.mode = mode;
 
+    publish_ipc_event(IPC_EVENT_MODE, "%#" PRIx32 " %s", window->client.id,
+            window_mode_names[mode]);
+
     if (window->state.is_visible) {
         /* pop out from tiling layout */
         if (window->state.previous_mode == WINDOW_MODE_TILING) {
@@ -478,7 +497,7 @@ void set_window_mode(Window *window, window_mode_t mode)
             Frame *const frame = get_frame_of_window(window);
             window->state.mode = mode;
 
-            frame->window = NULL;
+            set_frame_window(frame, NULL);
             if (configuration.tiling.auto_remove ||
                     configuration.tiling.auto_remove_void) {
                 /* do not remove a root */
@@ -516,6 +535,8 @@ void set_window_mode(Window *window, window_mode_t mode)
 
     update_window_layer(window);
 
+    mark_window_dirty(window);
+
     synchronize_allowed_actions(window);
 }
 
@@ -529,6 +550,8 @@ void show_window(Window *window)
     update_shown_window(window);
 
     window->state.is_visible = true;
+
+    mark_window_dirty(window);
 }
 
 /* Hide @window and adjust the tiling and focus. */
@@ -618,6 +641,8 @@ void hide_window(Window *window)
     }
 
     window->state.is_visible = false;
+
+    mark_window_dirty(window);
 }
 
 /* Hide the window without touching the tiling or focus. */
@@ -630,6 +655,8 @@ void hide_window_abruptly(Window *window)
 
     window->state.is_visible = false;
 
+    mark_window_dirty(window);
+
     /* make sure there is no invalid focus window */
     if (window == Window_focus) {
         set_focus_window(NULL);
@@ -1,6 +1,7 @@
 #include <inttypes.h>
 #include <string.h>
 
+#include "latency.h"
 #include "log.h"
 #include "fensterchef.h"
 #include "window.h"
@@ -105,11 +106,12 @@ static int create_utility_windows(void)
      * identify our window manager, we also use it as fallback focus
      */
     wm_check_window = xcb_generate_id(connection);
-    error = xcb_request_check(connection, xcb_create_window_checked(connection,
+    error = ROUND_TRIP(xcb_request_check(connection,
+            xcb_create_window_checked(connection,
                 XCB_COPY_FROM_PARENT, wm_check_window,
                 screen->root, -1, -1, 1, 1, 0,
                 XCB_WINDOW_CLASS_INPUT_ONLY, XCB_COPY_FROM_PARENT,
-                0, NULL));
+                0, NULL)));
     if (error != NULL) {
         LOG_ERROR("could not create check window: %E\n", error);
         free(error);
@@ -134,12 +136,16 @@ static int create_utility_windows(void)
     notification.height = 1;
     /* indicate to not manage the window */
     general_values[0] = true;
-    error = xcb_request_check(connection, xcb_create_window_checked(connection,
+    /* get expose events to redraw the notification */
+    general_values[1] = XCB_EVENT_MASK_EXPOSURE;
+    error = ROUND_TRIP(xcb_request_check(connection,
+            xcb_create_window_checked(connection,
                 XCB_COPY_FROM_PARENT, notification.id,
                 screen->root, notification.x, notification.y,
                 notification.width, notification.height, 0,
                 XCB_WINDOW_CLASS_COPY_FROM_PARENT, XCB_COPY_FROM_PARENT,
-                XCB_CW_OVERRIDE_REDIRECT, general_values));
+                XCB_CW_OVERRIDE_REDIRECT | XCB_CW_EVENT_MASK,
+                general_values)));
     if (error != NULL) {
         LOG_ERROR("could not create notification window: %E\n", error);
         free(error);
@@ -164,9 +170,9 @@ int take_control(void)
      * map requests
      */
     general_values[0] = ROOT_EVENT_MASK;
-    error = xcb_request_check(connection,
+    error = ROUND_TRIP(xcb_request_check(connection,
             xcb_change_window_attributes_checked(connection, screen->root,
-                XCB_CW_EVENT_MASK, general_values));
+                XCB_CW_EVENT_MASK, general_values)));
     if (error != NULL) {
         LOG_ERROR("could not change root window mask: %E\n", error);
         free(error);
@@ -187,17 +193,21 @@ int take_control(void)
 /* Go through all existing windows and manage them. */
 void query_existing_windows(void)
 {
+    uint64_t start;
     xcb_query_tree_cookie_t tree_cookie;
     xcb_query_tree_reply_t *tree;
     xcb_window_t *windows;
     int length;
+    struct window_requests *requests;
     Window *window;
     struct configuration_association association;
 
+    start = get_monotonic_time();
+
     /* get a list of child windows of the root in bottom-to-top stacking order
      */
     tree_cookie = xcb_query_tree(connection, screen->root);
-    tree = xcb_query_tree_reply(connection, tree_cookie, NULL);
+    tree = ROUND_TRIP(xcb_query_tree_reply(connection, tree_cookie, NULL));
     /* not sure what this implies, maybe the connection is broken */
     if (tree == NULL) {
         return;
@@ -205,23 +215,40 @@ void query_existing_windows(void)
 
     windows = xcb_query_tree_children(tree);
     length = xcb_query_tree_children_length(tree);
+
+    /* send the requests for all windows first, this way we only wait for the
+     * round trip once and not for every window
+     */
+    requests = xmalloc(sizeof(*requests) * length);
     for (int i = 0; i < length; i++) {
-        window = create_window(windows[i], &association);
+        send_window_requests(windows[i], &requests[i]);
+    }
+
+    for (int i = 0; i < length; i++) {
+        window = create_window_from_replies(&requests[i], &association);
         if (window != NULL && window->client.is_mapped) {
             show_window(window);
         }
     }
 
+    free(requests);
     free(tree);
+
+    LOG("adopted %" PRIu32 " of %d existing windows in %" PRIu64
+                " microseconds\n",
+            Window_count, length, (get_monotonic_time() - start) / 1000);
 }
 
 /* Set the input focus to @window. This window may be `NULL`. */
 void set_input_focus(Window *window)
 {
+    uint64_t start;
     xcb_window_t focus_id = XCB_NONE;
     xcb_window_t active_id;
     xcb_atom_t state_atom;
 
+    start = get_monotonic_time();
+
     if (window == NULL) {
         LOG("removed focus from all windows\n");
         active_id = screen->root;
@@ -266,6 +293,8 @@ void set_input_focus(Window *window)
 
     xcb_change_property(connection, XCB_PROP_MODE_REPLACE, screen->root,
             ATOM(_NET_ACTIVE_WINDOW), XCB_ATOM_WINDOW, 32, 1, &active_id);
+
+    record_latency(LATENCY_SET_INPUT_FOCUS, start);
 }
 
 /* Show the client on the X server. */